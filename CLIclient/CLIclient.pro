@@ -6,6 +6,7 @@ CONFIG += console
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+        loadgenerator.cpp \
         main.cpp
 
 # Default rules for deployment.
@@ -14,6 +15,9 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
 
 HEADERS += \
-    json.hpp
+    BinaryProtocol.h \
+    json.hpp \
+    latencyhistogram.h \
+    loadgenerator.h
 
 RESOURCES +=
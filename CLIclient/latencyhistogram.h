@@ -0,0 +1,123 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+// Гистограмма задержек в духе HdrHistogram: логарифмические корзины
+// с линейными подкорзинами. Корзина 0 — 128 подкорзин шириной 1 (точные
+// значения 0..127), корзина k ≥ 1 — 64 подкорзины шириной 2^k на
+// [64·2^k, 128·2^k). Относительная погрешность не хуже 1/64 (~1.6%) во всём
+// диапазоне, память фиксирована, record() — O(1). Значения в микросекундах.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 7;
+    static constexpr std::uint64_t SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;
+    static constexpr std::uint64_t SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;
+    static constexpr int MAX_BUCKET = 32; // до ~2^38 мкс, с запасом
+
+    LatencyHistogram() : counts(std::size_t((MAX_BUCKET + 1) * SUB_BUCKET_HALF + SUB_BUCKET_HALF), 0) {}
+
+    void record(std::uint64_t value) {
+        value = std::min(value, highestTrackable());
+        ++counts[indexOf(value)];
+        ++total;
+        sum += value;
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+    }
+
+    void add(const LatencyHistogram& other) {
+        for (std::size_t i = 0; i < counts.size(); ++i) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        sum += other.sum;
+        minValue = std::min(minValue, other.minValue);
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+
+    std::uint64_t count() const { return total; }
+    std::uint64_t min() const { return total ? minValue : 0; }
+    std::uint64_t max() const { return maxValue; }
+    double mean() const { return total ? double(sum) / double(total) : 0.0; }
+
+    // Наибольшее значение, эквивалентное корзине, где накопилось percentile% записей
+    std::uint64_t valueAtPercentile(double percentile) const {
+        if (total == 0) return 0;
+        double fraction = std::clamp(percentile, 0.0, 100.0) / 100.0;
+        auto target = std::max<std::uint64_t>(1, std::uint64_t(fraction * double(total) + 0.5));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= target) {
+                return std::min(highestEquivalent(i), maxValue);
+            }
+        }
+        return maxValue;
+    }
+
+    // Распределение по перцентилям (0, 50, 75, 87.5, ...) как в выводе HdrHistogram
+    void printPercentiles(std::FILE* out, const char* label) const {
+        std::fprintf(out, "%s percentile distribution:\n", label);
+        std::fprintf(out, "%12s %12s %12s\n", "value_us", "percentile", "total_count");
+        if (total == 0) return;
+        double percentile = 0.0;
+        double step = 50.0;
+        while (true) {
+            std::uint64_t value = valueAtPercentile(percentile);
+            std::fprintf(out, "%12llu %12.5f %12llu\n",
+                         static_cast<unsigned long long>(value), percentile,
+                         static_cast<unsigned long long>(countAtOrBelow(value)));
+            if (value >= maxValue || step < 0.001) break;
+            percentile += step;
+            step /= 2.0;
+        }
+        std::fprintf(out, "%12llu %12.5f %12llu\n",
+                     static_cast<unsigned long long>(maxValue), 100.0,
+                     static_cast<unsigned long long>(total));
+    }
+
+private:
+    static std::uint64_t highestTrackable() {
+        return (std::uint64_t(SUB_BUCKET_COUNT) << MAX_BUCKET) - 1;
+    }
+
+    // Корзина 0 — значения 0..127 один в один; корзина b ≥ 1 хранит
+    // старшие 7 бит значения (64..127), сдвинутые на b
+    static std::size_t indexOf(std::uint64_t value) {
+        int bucket = 0;
+        while ((value >> bucket) >= SUB_BUCKET_COUNT) {
+            ++bucket;
+        }
+        std::uint64_t sub = value >> bucket;
+        return bucket == 0 ? std::size_t(sub) : std::size_t(bucket * SUB_BUCKET_HALF + sub);
+    }
+
+    static std::uint64_t highestEquivalent(std::size_t index) {
+        if (index < SUB_BUCKET_COUNT) return index;
+        std::size_t bucket = (index - SUB_BUCKET_HALF) / SUB_BUCKET_HALF;
+        std::uint64_t sub = index - bucket * SUB_BUCKET_HALF;
+        return ((sub + 1) << bucket) - 1;
+    }
+
+    std::uint64_t countAtOrBelow(std::uint64_t value) const {
+        std::uint64_t seen = 0;
+        std::size_t last = indexOf(std::min(value, highestTrackable()));
+        for (std::size_t i = 0; i <= last; ++i) {
+            seen += counts[i];
+        }
+        return seen;
+    }
+
+    std::vector<std::uint64_t> counts;
+    std::uint64_t total = 0;
+    std::uint64_t sum = 0;
+    std::uint64_t minValue = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t maxValue = 0;
+};
+
+#endif // LATENCYHISTOGRAM_H
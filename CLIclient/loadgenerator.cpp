@@ -0,0 +1,331 @@
+#include "loadgenerator.h"
+#include "BinaryProtocol.h"
+#include "json.hpp"
+#include <QCoreApplication>
+#include <QDebug>
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+constexpr qint64 NS_PER_SECOND = 1000000000;
+constexpr int TICK_MS = 1;
+constexpr int CONNECT_TIMEOUT_MS = 5000;
+constexpr int DRAIN_TIMEOUT_MS = 5000;
+
+}
+
+LoadGenerator::LoadGenerator(const LoadOptions& opts)
+    : options(opts)
+    , random(opts.seed)
+{
+    options.connections = std::max(1, options.connections);
+    options.pipeline = std::max(1, options.pipeline);
+    options.rate = std::max(0.001, options.rate);
+    // JSON-ответы разделяются только '\n', а запросы сервер не разделяет вовсе:
+    // два склеенных в один TCP-сегмент JSON-пакета он не разберёт
+    if (!options.binary && options.pipeline > 1) {
+        qDebug() << "JSON protocol cannot pipeline, using --pipeline 1";
+        options.pipeline = 1;
+    }
+
+    ticker.setTimerType(Qt::PreciseTimer);
+    ticker.setInterval(TICK_MS);
+    QObject::connect(&ticker, &QTimer::timeout, [this]() { tick(); });
+}
+
+LoadGenerator::~LoadGenerator()
+{
+    for (auto& connection : connections) {
+        delete connection->socket;
+    }
+}
+
+void LoadGenerator::start()
+{
+    clock.start();
+    for (int i = 0; i < options.connections; ++i) {
+        auto connection = std::make_unique<Connection>();
+        Connection* raw = connection.get();
+        raw->socket = new QTcpSocket();
+        raw->socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        QObject::connect(raw->socket, &QTcpSocket::connected, [this, raw]() { onConnected(*raw); });
+        QObject::connect(raw->socket, &QTcpSocket::readyRead, [this, raw]() { onReadyRead(*raw); });
+        QObject::connect(raw->socket, &QTcpSocket::disconnected, [this, raw]() { onClosed(*raw); });
+        QObject::connect(raw->socket, &QAbstractSocket::errorOccurred, [this, raw]() { onClosed(*raw); });
+        connections.push_back(std::move(connection));
+        raw->socket->connectToHost(options.host, options.port);
+    }
+
+    QTimer::singleShot(CONNECT_TIMEOUT_MS, [this]() {
+        if (phase == Phase::CONNECTING) {
+            qDebug() << "Not all connections are ready after" << CONNECT_TIMEOUT_MS << "ms";
+            finish();
+        }
+    });
+}
+
+void LoadGenerator::onConnected(Connection& connection)
+{
+    if (options.binary) {
+        std::uint8_t hello[binproto::HELLO_SIZE];
+        binproto::writeHello(hello);
+        connection.socket->write(reinterpret_cast<const char*>(hello), sizeof(hello));
+        return; // готово после ответного HELLO
+    }
+    connection.ready = true;
+    begin();
+}
+
+// Старт одновременно для всех соединений; графики сдвинуты друг
+// относительно друга, чтобы запросы шли равномерно, а не пачками
+void LoadGenerator::begin()
+{
+    if (phase != Phase::CONNECTING) return;
+    for (const auto& connection : connections) {
+        if (!connection->ready) return;
+    }
+
+    qint64 globalIntervalNs = qint64(double(NS_PER_SECOND) / options.rate);
+    intervalNs = globalIntervalNs * options.connections;
+    startNs = clock.nsecsElapsed();
+    endNs = startNs + qint64(options.duration * double(NS_PER_SECOND));
+    for (std::size_t i = 0; i < connections.size(); ++i) {
+        connections[i]->nextSendNs = startNs + qint64(i) * globalIntervalNs;
+    }
+    phase = Phase::RUNNING;
+    ticker.start();
+    tick();
+}
+
+void LoadGenerator::tick()
+{
+    qint64 now = clock.nsecsElapsed();
+
+    if (phase == Phase::RUNNING && now >= endNs) {
+        phase = Phase::DRAINING;
+        for (const auto& connection : connections) {
+            for (qint64 t = connection->nextSendNs; t < endNs; t += intervalNs) {
+                ++backlog;
+            }
+        }
+        QTimer::singleShot(DRAIN_TIMEOUT_MS, [this]() {
+            if (phase == Phase::DRAINING) finish();
+        });
+        finishIfDrained();
+        return;
+    }
+    if (phase != Phase::RUNNING) return;
+
+    for (auto& connection : connections) {
+        sendDue(*connection, now);
+    }
+}
+
+void LoadGenerator::sendDue(Connection& connection, qint64 now)
+{
+    if (!connection.ready) return;
+    bool wrote = false;
+    while (connection.nextSendNs <= now && connection.nextSendNs < endNs
+           && int(connection.inFlight.size()) < options.pipeline) {
+        send(connection, connection.nextSendNs);
+        connection.nextSendNs += intervalNs;
+        wrote = true;
+    }
+    if (wrote) {
+        connection.socket->flush();
+    }
+}
+
+void LoadGenerator::send(Connection& connection, qint64 intendedNs)
+{
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    RequestKind kind = chance(random) < options.stateRatio ? RequestKind::GET_STATE : RequestKind::SUMMON;
+
+    // союзники слева, враги справа — как в обычной игре
+    bool ally = chance(random) < 0.5f;
+    float x = ally ? -4.0f + 3.0f * chance(random) : 1.0f + 3.0f * chance(random);
+    float y = -3.0f + 6.0f * chance(random);
+
+    std::uint32_t sequence = connection.nextSequence++;
+    QByteArray packet;
+    if (options.binary) {
+        binproto::CommandRecord record;
+        record.sequence = sequence;
+        if (kind == RequestKind::GET_STATE) {
+            record.op = binproto::Op::GET_STATE;
+        } else {
+            record.op = binproto::Op::SUMMON;
+            record.unit = std::uint8_t(ally ? binproto::UnitType::SOLDIER : binproto::UnitType::ENEMY);
+            record.x = binproto::quantize(x);
+            record.y = binproto::quantize(y);
+        }
+        std::uint8_t bytes[binproto::RECORD_SIZE];
+        binproto::encode(record, bytes);
+        packet = QByteArray(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+    } else if (kind == RequestKind::GET_STATE) {
+        packet = "get_state";
+    } else {
+        nlohmann::json j;
+        j["commands"] = nlohmann::json::array();
+        j["commands"].push_back({ { "action", "summon" }, { "unit", ally ? "soldier" : "enemy" }, { "x", x }, { "y", y } });
+        packet = QByteArray::fromStdString(j.dump());
+    }
+
+    connection.socket->write(packet);
+    connection.inFlight.push_back({sequence, kind, intendedNs});
+    bytesOut += std::uint64_t(packet.size());
+    ++sent;
+}
+
+void LoadGenerator::onReadyRead(Connection& connection)
+{
+    QByteArray data = connection.socket->readAll();
+    bytesIn += std::uint64_t(data.size());
+    connection.received.append(data);
+
+    if (options.binary && !connection.ready) {
+        if (connection.received.size() < int(binproto::HELLO_SIZE)) return;
+        auto version = binproto::readHello(reinterpret_cast<const std::uint8_t*>(connection.received.constData()));
+        if (version == 0) {
+            qDebug() << "Server does not speak the binary protocol";
+            finish();
+            return;
+        }
+        connection.received.remove(0, int(binproto::HELLO_SIZE));
+        connection.ready = true;
+        begin();
+    }
+
+    int offset = 0;
+    if (options.binary) {
+        const auto* bytes = reinterpret_cast<const std::uint8_t*>(connection.received.constData());
+        while (connection.received.size() - offset >= int(binproto::REPLY_HEADER_SIZE)) {
+            binproto::ReplyHeader header = binproto::decodeReply(bytes + offset);
+            int frameSize = int(binproto::REPLY_HEADER_SIZE + header.payloadSize);
+            if (connection.received.size() - offset < frameSize) break;
+            offset += frameSize;
+            complete(connection, header.sequence, header.status == binproto::Status::OK);
+        }
+    } else {
+        // Конвейера в JSON-режиме нет: ответ относится к единственному запросу
+        int newline;
+        while ((newline = connection.received.indexOf('\n', offset)) >= 0) {
+            bool ok = !connection.received.mid(offset, newline - offset).startsWith("JSON parse error");
+            offset = newline + 1;
+            if (!connection.inFlight.empty()) {
+                complete(connection, connection.inFlight.front().sequence, ok);
+            } else {
+                ++unmatched;
+            }
+        }
+    }
+    connection.received.remove(0, offset);
+
+    if (phase == Phase::RUNNING) {
+        sendDue(connection, clock.nsecsElapsed());
+    }
+    finishIfDrained();
+}
+
+void LoadGenerator::complete(Connection& connection, std::uint32_t sequence, bool ok)
+{
+    // сервер отвечает по порядку, поиск нужен только на случай сбоя
+    auto it = connection.inFlight.begin();
+    if (it == connection.inFlight.end() || it->sequence != sequence) {
+        it = std::find_if(connection.inFlight.begin(), connection.inFlight.end(),
+                          [sequence](const Pending& p) { return p.sequence == sequence; });
+        if (it == connection.inFlight.end()) {
+            ++unmatched;
+            return;
+        }
+    }
+
+    qint64 now = clock.nsecsElapsed();
+    auto latencyUs = std::uint64_t(std::max<qint64>(0, now - it->intendedNs) / 1000);
+    (it->kind == RequestKind::GET_STATE ? stateLatency : summonLatency).record(latencyUs);
+    connection.inFlight.erase(it);
+    lastReplyNs = now;
+    ++completed;
+    if (!ok) ++errors;
+}
+
+void LoadGenerator::onClosed(Connection& connection)
+{
+    // errorOccurred и disconnected могут прийти оба
+    if (phase == Phase::DONE || connection.closed) return;
+    connection.closed = true;
+    connection.ready = false;
+    ++disconnects;
+    qDebug() << "Connection closed:" << connection.socket->errorString();
+
+    bool anyAlive = std::any_of(connections.begin(), connections.end(),
+                                [](const auto& c) { return !c->closed; });
+    if (!anyAlive) finish();
+}
+
+void LoadGenerator::finishIfDrained()
+{
+    if (phase != Phase::DRAINING) return;
+    for (const auto& connection : connections) {
+        if (connection->ready && !connection->inFlight.empty()) return;
+    }
+    finish();
+}
+
+void LoadGenerator::finish()
+{
+    if (phase == Phase::DONE) return;
+    phase = Phase::DONE;
+    ticker.stop();
+    printSummary();
+    for (auto& connection : connections) {
+        connection->socket->abort();
+    }
+    QCoreApplication::quit();
+}
+
+// Формат стабильный: ключ=значение, одна метрика на строку, чтобы
+// сводки разных сборок сервера можно было сравнивать через diff
+void LoadGenerator::printSummary() const
+{
+    std::uint64_t outstanding = 0;
+    for (const auto& connection : connections) {
+        outstanding += connection->inFlight.size();
+    }
+    double seconds = startNs && lastReplyNs > startNs ? double(lastReplyNs - startNs) / NS_PER_SECOND : 0.0;
+
+    LatencyHistogram all = summonLatency;
+    all.add(stateLatency);
+
+    std::printf("protocol=%s connections=%d rate=%.1f pipeline=%d duration=%.1f state_ratio=%.2f\n",
+                options.binary ? "binary" : "json", options.connections, options.rate,
+                options.pipeline, options.duration, options.stateRatio);
+    std::printf("sent=%llu completed=%llu errors=%llu outstanding=%llu backlog=%llu unmatched=%llu disconnects=%llu\n",
+                static_cast<unsigned long long>(sent), static_cast<unsigned long long>(completed),
+                static_cast<unsigned long long>(errors), static_cast<unsigned long long>(outstanding),
+                static_cast<unsigned long long>(backlog), static_cast<unsigned long long>(unmatched),
+                static_cast<unsigned long long>(disconnects));
+    std::printf("throughput_rps=%.1f bytes_out=%llu bytes_in=%llu\n",
+                seconds > 0.0 ? double(completed) / seconds : 0.0,
+                static_cast<unsigned long long>(bytesOut), static_cast<unsigned long long>(bytesIn));
+
+    auto printLatency = [](const char* label, const LatencyHistogram& h) {
+        std::printf("%s_us count=%llu min=%llu p50=%llu p90=%llu p99=%llu p99.9=%llu max=%llu mean=%.1f\n",
+                    label, static_cast<unsigned long long>(h.count()),
+                    static_cast<unsigned long long>(h.min()),
+                    static_cast<unsigned long long>(h.valueAtPercentile(50.0)),
+                    static_cast<unsigned long long>(h.valueAtPercentile(90.0)),
+                    static_cast<unsigned long long>(h.valueAtPercentile(99.0)),
+                    static_cast<unsigned long long>(h.valueAtPercentile(99.9)),
+                    static_cast<unsigned long long>(h.max()), h.mean());
+    };
+    printLatency("latency", all);
+    printLatency("summon", summonLatency);
+    printLatency("get_state", stateLatency);
+
+    if (options.printHistogram) {
+        all.printPercentiles(stdout, "latency");
+    }
+    std::fflush(stdout);
+}
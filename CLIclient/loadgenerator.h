@@ -0,0 +1,98 @@
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+#include <QTcpSocket>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QString>
+#include <deque>
+#include <memory>
+#include <random>
+#include <vector>
+#include "latencyhistogram.h"
+
+struct LoadOptions {
+    QString host = "127.0.0.1";
+    quint16 port = 12345;
+    int connections = 1;
+    double rate = 100.0;      // запросов в секунду суммарно по всем соединениям
+    int pipeline = 8;         // максимум запросов "в полёте" на соединение
+    double duration = 10.0;   // секунд отправки
+    double stateRatio = 0.1;  // доля get_state среди запросов
+    bool binary = false;
+    bool printHistogram = false;
+    quint32 seed = 1;
+};
+
+// Генератор нагрузки: N соединений, открытый график отправки с заданной
+// частотой, конвейер до pipeline запросов на соединение. Задержка считается
+// от планового времени отправки, а не от фактического: если сервер не
+// успевает и конвейер забит, ожидание попадает в гистограмму
+// (поправка на coordinated omission, как в wrk2/HdrHistogram).
+class LoadGenerator {
+public:
+    explicit LoadGenerator(const LoadOptions& options);
+    ~LoadGenerator();
+
+    // Подключается и гонит нагрузку; по окончании печатает сводку
+    // в stdout и вызывает QCoreApplication::quit()
+    void start();
+
+private:
+    enum class RequestKind { SUMMON, GET_STATE };
+    enum class Phase { CONNECTING, RUNNING, DRAINING, DONE };
+
+    struct Pending {
+        std::uint32_t sequence;
+        RequestKind kind;
+        qint64 intendedNs;
+    };
+
+    struct Connection {
+        QTcpSocket* socket = nullptr;
+        QByteArray received;
+        bool ready = false;
+        bool closed = false;
+        std::uint32_t nextSequence = 1;
+        std::deque<Pending> inFlight;
+        qint64 nextSendNs = 0;
+    };
+
+    void onConnected(Connection& connection);
+    void onReadyRead(Connection& connection);
+    void onClosed(Connection& connection);
+    void begin();
+    void tick();
+    void sendDue(Connection& connection, qint64 now);
+    void send(Connection& connection, qint64 intendedNs);
+    void complete(Connection& connection, std::uint32_t sequence, bool ok);
+    void finishIfDrained();
+    void finish();
+    void printSummary() const;
+
+    LoadOptions options;
+    std::vector<std::unique_ptr<Connection>> connections;
+    QTimer ticker;
+    QElapsedTimer clock;
+    Phase phase = Phase::CONNECTING;
+    std::mt19937 random;
+
+    qint64 intervalNs = 0;   // шаг графика внутри одного соединения
+    qint64 startNs = 0;
+    qint64 endNs = 0;
+    qint64 lastReplyNs = 0;
+
+    std::uint64_t sent = 0;
+    std::uint64_t completed = 0;
+    std::uint64_t errors = 0;
+    std::uint64_t unmatched = 0;
+    std::uint64_t backlog = 0;      // запланированы, но не отправлены: конвейер был полон
+    std::uint64_t disconnects = 0;
+    std::uint64_t bytesOut = 0;
+    std::uint64_t bytesIn = 0;
+
+    LatencyHistogram summonLatency;
+    LatencyHistogram stateLatency;
+};
+
+#endif // LOADGENERATOR_H
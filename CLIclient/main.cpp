@@ -1,23 +1,89 @@
 #include <QCoreApplication>
 #include <QTcpSocket>
 #include <QTimer>
+#include <QCommandLineParser>
 #include "json.hpp"
+#include "BinaryProtocol.h"
+#include "loadgenerator.h"
 #include <QDebug>
 
+struct SummonSpec {
+    binproto::UnitType unit;
+    const char* name;
+    float x;
+    float y;
+};
+
+static const SummonSpec SUMMONS[] = {
+    { binproto::UnitType::ARCHER,  "archer",  -3.3f,  0.0f },
+    { binproto::UnitType::SOLDIER, "soldier", -2.3f,  0.0f },
+    { binproto::UnitType::ENEMY,   "enemy",    2.3f,  0.0f },
+    { binproto::UnitType::ENEMY,   "enemy",    2.3f,  1.0f },
+    { binproto::UnitType::FORT,    "fort",    -4.0f, -2.0f },
+};
+
 int main(int argc, char *argv[]) {
     QCoreApplication app(argc, argv);
 
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Sends summon commands to the engine server; with --load runs a load test.");
+    parser.addHelpOption();
+    QCommandLineOption binaryOption("binary", "Use the binary protocol instead of JSON.");
+    QCommandLineOption loadOption("load", "Run as a load generator and print a latency/throughput summary.");
+    QCommandLineOption hostOption("host", "Server host.", "host", "127.0.0.1");
+    QCommandLineOption portOption("port", "Server port.", "port", "12345");
+    QCommandLineOption connectionsOption("connections", "Concurrent connections.", "n", "1");
+    QCommandLineOption rateOption("rate", "Target requests per second over all connections.", "rps", "100");
+    QCommandLineOption pipelineOption("pipeline", "Max requests in flight per connection (binary only).", "n", "8");
+    QCommandLineOption durationOption("duration", "Seconds to send for.", "s", "10");
+    QCommandLineOption stateRatioOption("state-ratio", "Fraction of get_state requests, the rest are summons.", "f", "0.1");
+    QCommandLineOption seedOption("seed", "Random seed for positions and the request mix.", "n", "1");
+    QCommandLineOption histogramOption("histogram", "Also print the full percentile distribution.");
+    parser.addOptions({ binaryOption, loadOption, hostOption, portOption, connectionsOption, rateOption,
+                        pipelineOption, durationOption, stateRatioOption, seedOption, histogramOption });
+    parser.process(app);
+
+    // --binary: компактный бинарный протокол вместо JSON
+    bool binary = parser.isSet(binaryOption);
+
+    if (parser.isSet(loadOption)) {
+        LoadOptions options;
+        options.host = parser.value(hostOption);
+        options.port = quint16(parser.value(portOption).toUInt());
+        options.connections = parser.value(connectionsOption).toInt();
+        options.rate = parser.value(rateOption).toDouble();
+        options.pipeline = parser.value(pipelineOption).toInt();
+        options.duration = parser.value(durationOption).toDouble();
+        options.stateRatio = parser.value(stateRatioOption).toDouble();
+        options.seed = parser.value(seedOption).toUInt();
+        options.binary = binary;
+        options.printHistogram = parser.isSet(histogramOption);
+
+        LoadGenerator generator(options);
+        generator.start();
+        return app.exec();
+    }
+
     QTcpSocket socket;
+    QByteArray received;
+    bool negotiated = false;
+    std::uint32_t expectedReplies = 0;
 
     QObject::connect(&socket, &QTcpSocket::connected, [&]() {
+        if (binary) {
+            std::uint8_t hello[binproto::HELLO_SIZE];
+            binproto::writeHello(hello);
+            socket.write(reinterpret_cast<const char*>(hello), sizeof(hello));
+            socket.flush();
+            qDebug() << "Binary HELLO sent";
+            return;
+        }
+
         nlohmann::json j;
-        j["commands"] = {
-            { { "action", "summon" }, { "unit", "archer" }, { "x", -3.3 }, { "y", 0.0 } },
-            { { "action", "summon" }, { "unit", "soldier" }, { "x", -2.3 }, { "y", 0.0 } },
-            { { "action", "summon" }, { "unit", "enemy" },   { "x",  2.3 }, { "y", 0.0 } },
-            { { "action", "summon" }, { "unit", "enemy" },   { "x",  2.3 }, { "y", 1.0 } },
-            { { "action", "summon" }, { "unit", "fort" },    { "x",  -4.0 }, { "y", -2.0 } }
-        };
+        j["commands"] = nlohmann::json::array();
+        for (const auto& s : SUMMONS) {
+            j["commands"].push_back({ { "action", "summon" }, { "unit", s.name }, { "x", s.x }, { "y", s.y } });
+        }
         QByteArray data = QString::fromStdString(j.dump()).toUtf8();
         socket.write(data);
         socket.flush();
@@ -25,14 +91,74 @@ int main(int argc, char *argv[]) {
     });
 
     QObject::connect(&socket, &QTcpSocket::readyRead, [&]() {
-        QByteArray response = socket.readAll();
-        qDebug() << "Sever answer:" << response;
-        QCoreApplication::quit();
+        if (!binary) {
+            QByteArray response = socket.readAll();
+            qDebug() << "Sever answer:" << response;
+            QCoreApplication::quit();
+            return;
+        }
+
+        received.append(socket.readAll());
+        const auto* bytes = reinterpret_cast<const std::uint8_t*>(received.constData());
+
+        if (!negotiated) {
+            if (received.size() < int(binproto::HELLO_SIZE)) return;
+            std::uint8_t version = binproto::readHello(bytes);
+            if (version == 0) {
+                qDebug() << "Server does not speak the binary protocol";
+                QCoreApplication::quit();
+                return;
+            }
+            negotiated = true;
+            received.remove(0, int(binproto::HELLO_SIZE));
+            qDebug() << "Binary protocol negotiated, version" << version;
+
+            QByteArray batch;
+            std::uint32_t sequence = 1;
+            std::uint8_t record[binproto::RECORD_SIZE];
+            for (const auto& s : SUMMONS) {
+                binproto::CommandRecord r;
+                r.sequence = sequence++;
+                r.op = binproto::Op::SUMMON;
+                r.unit = std::uint8_t(s.unit);
+                r.x = binproto::quantize(s.x);
+                r.y = binproto::quantize(s.y);
+                binproto::encode(r, record);
+                batch.append(reinterpret_cast<const char*>(record), sizeof(record));
+            }
+            binproto::CommandRecord state;
+            state.sequence = sequence++;
+            state.op = binproto::Op::GET_STATE;
+            binproto::encode(state, record);
+            batch.append(reinterpret_cast<const char*>(record), sizeof(record));
+
+            expectedReplies = sequence - 1;
+            socket.write(batch);
+            socket.flush();
+            qDebug() << "Sent" << expectedReplies << "binary records (" << batch.size() << "bytes)";
+            bytes = reinterpret_cast<const std::uint8_t*>(received.constData());
+        }
+
+        int offset = 0;
+        while (received.size() - offset >= int(binproto::REPLY_HEADER_SIZE)) {
+            binproto::ReplyHeader header = binproto::decodeReply(bytes + offset);
+            int frameSize = int(binproto::REPLY_HEADER_SIZE + header.payloadSize);
+            if (received.size() - offset < frameSize) break;
+
+            QByteArray payload = received.mid(offset + int(binproto::REPLY_HEADER_SIZE), int(header.payloadSize));
+            qDebug() << "Reply seq" << header.sequence << "op" << int(header.op)
+                     << "status" << int(header.status) << payload;
+            offset += frameSize;
+            if (--expectedReplies == 0) {
+                QCoreApplication::quit();
+            }
+        }
+        received.remove(0, offset);
     });
 
     QTimer::singleShot(5000, &app, &QCoreApplication::quit);
 
-    socket.connectToHost("127.0.0.1", 12345);
+    socket.connectToHost(parser.value(hostOption), quint16(parser.value(portOption).toUInt()));
 
     return app.exec();
 }
@@ -9,14 +9,20 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    glyphatlas.cpp \
     main.cpp \
     mainwindow.cpp \
-    myopenglwidget.cpp
+    myopenglwidget.cpp \
+    spriterenderer.cpp \
+    textureatlas.cpp
 
 HEADERS += \
+    glyphatlas.h \
     json.hpp \
     mainwindow.h \
-    myopenglwidget.h
+    myopenglwidget.h \
+    spriterenderer.h \
+    textureatlas.h
 
 FORMS += \
     mainwindow.ui
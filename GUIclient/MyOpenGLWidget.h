@@ -6,17 +6,47 @@
 #include <QMap>
 #include <QString>
 #include <QVector>
+#include <QElapsedTimer>
+#include <QPointF>
+#include <QRectF>
 #include "json.hpp"
+#include "spriterenderer.h"
+#include "textureatlas.h"
+#include "glyphatlas.h"
 
 
+// Положение сущности на момент прихода сообщения сервера (мс по часам виджета)
+struct PositionSample {
+    qint64 time;
+    float x, y;
+};
+
+// Подпись "HP: N", собранная из глифов; пересобирается только при смене HP
+struct HpLabel {
+    float hp = 0;
+    char text[16] = {};
+    int length = 0;
+    float width = 0;  // в пикселях
+};
+
 struct GuiEntity {
     int id;
     QString type;
-    float x, y;
+    float x, y;   // последнее присланное сервером
     float hp;
+    float maxHp = 0;  // сервер шлёт только текущее HP: максимум — наибольшее виденное
+    HpLabel hpLabel;
     QString texture;
+    TextureId textureId = TextureAtlas::FALLBACK;  // ищется в атласе при смене texture
     float width;
     float height;
+
+    // История положений для интерполяции, от старых к новым
+    static constexpr int HISTORY_SIZE = 4;
+    PositionSample history[HISTORY_SIZE];
+    int historySize = 0;
+    qint64 removedAt = -1;  // когда сервер сообщил об удалении; -1 — жива
+    int lastMessage = 0;    // номер последнего полного снимка, где она была
 };
 
 class MyOpenGLWidget : public QOpenGLWidget, protected QOpenGLFunctions
@@ -24,21 +54,58 @@ class MyOpenGLWidget : public QOpenGLWidget, protected QOpenGLFunctions
     Q_OBJECT
 public:
     MyOpenGLWidget(QWidget* parent = nullptr);
+    ~MyOpenGLWidget() override;
 
     // Обновление данных сцены из JSON (от сервера)
     void updateSceneFromJson(const QByteArray& data);
 
+    // Дельта подписки: {"delta":N,"remove":[...],"upsert":[...]}.
+    // Трогает только перечисленные сущности, остальные остаются как были.
+    void applyStateDelta(const QByteArray& data);
+
+    // Рисуем с задержкой: между двумя снимками по 10 Гц плюс запас на джиттер
+    static constexpr qint64 INTERPOLATION_DELAY_MS = 150;
+    // Если снимки опаздывают, движение продолжается по скорости не дольше этого
+    static constexpr qint64 MAX_EXTRAPOLATION_MS = 250;
+
+    // Полоска HP, в мировых единицах
+    static constexpr float HP_BAR_HEIGHT = 0.06f;
+    static constexpr float HP_BAR_GAP = 0.05f;
+    static constexpr int LABEL_PIXEL_SIZE = 12;
+
+    // Видимая область в мировых координатах: камера в нуле, по cameraZoom
+    // единиц на каждую ось. margin — запас со всех сторон.
+    QRectF viewRect(float margin = 0.0f) const;
+
 protected:
     void initializeGL() override;
     void resizeGL(int w, int h) override;
     void paintGL() override;
 
 private:
-    QVector<GuiEntity> entities;
-    QMap<QString, QImage> textures;
+    QMap<int, GuiEntity> entities; // id → сущность, живёт между сообщениями
+    SpriteRenderer sprites;
+    TextureAtlas atlas;
+    GLuint atlasTexture = 0;
+    GlyphAtlas glyphs;
+    GLuint glyphTexture = 0;
     float cameraZoom = 10.0f;
 
-    void drawEntity(const GuiEntity& entity,  QPainter& painter);
+    QElapsedTimer clock;
+    qint64 lastMessageTime = -1;      // приход последнего сообщения
+    qint64 previousMessageTime = -1;  // и предыдущего
+    int messageCount = 0;
+
+    // Начало обработки сообщения сервера; возвращает его время
+    qint64 beginMessage();
+    GuiEntity& upsertEntity(int id);
+    void recordPosition(GuiEntity& entity, qint64 now, float x, float y);
+    QPointF sampledPosition(const GuiEntity& entity, qint64 renderTime) const;
+
+    void updateHpLabel(GuiEntity& entity);
+    // Задевает ли спрайт вместе с полоской HP и подписью видимую область
+    bool isVisible(const GuiEntity& entity, QPointF position, const QRectF& view) const;
+    void drawEntity(const GuiEntity& entity, QPointF position);
 
 };
 
@@ -0,0 +1,41 @@
+#include "glyphatlas.h"
+#include <QFontMetrics>
+#include <QPainter>
+#include <cmath>
+
+void GlyphAtlas::build(const QFont& font, const QString& characters)
+{
+    const int padding = 2;
+    QFontMetrics metrics(font);
+    lineHeight = float(metrics.height());
+
+    // Глифы в одну строку, с зазором от соседей для линейной фильтрации
+    int width = padding;
+    for (QChar c : characters) {
+        width += metrics.horizontalAdvance(c) + padding;
+    }
+    int height = metrics.height() + 2 * padding;
+
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    painter.setFont(font);
+    painter.setPen(Qt::white);
+
+    int x = padding;
+    for (QChar c : characters) {
+        char latin = c.toLatin1();
+        int advance = metrics.horizontalAdvance(c);
+        painter.drawText(QPointF(x, padding + metrics.ascent()), QString(c));
+        if (latin > 0) {
+            Glyph& glyph = glyphs[static_cast<unsigned char>(latin)];
+            glyph.uv = QRectF(double(x) / width, double(padding) / height,
+                              double(advance) / width, double(metrics.height()) / height);
+            glyph.advance = float(advance);
+            glyph.valid = true;
+        }
+        x += advance + padding;
+    }
+    painter.end();
+    atlas = image;
+}
@@ -0,0 +1,40 @@
+#ifndef GLYPHATLAS_H
+#define GLYPHATLAS_H
+
+#include <QFont>
+#include <QImage>
+#include <QRectF>
+#include <QString>
+
+// Заранее отрисованные символы подписей (цифры HP и пара букв) в одной
+// текстуре. Подпись на кадре — это квады из готовых глифов, без
+// QString::arg и раскладки текста через QPainter.
+class GlyphAtlas
+{
+public:
+    struct Glyph {
+        QRectF uv;
+        float advance = 0;  // ширина ячейки в пикселях
+        bool valid = false;
+    };
+
+    // Рисует characters белым (цвет задаётся при отрисовке) шрифтом font
+    void build(const QFont& font, const QString& characters);
+
+    // Символы вне набора возвращают пустой глиф (valid == false)
+    const Glyph& glyph(char c) const {
+        auto index = static_cast<unsigned char>(c);
+        return index < 128 ? glyphs[index] : glyphs[0];
+    }
+
+    // Высота строки в пикселях
+    float height() const { return lineHeight; }
+    const QImage& image() const { return atlas; }
+
+private:
+    Glyph glyphs[128];
+    float lineHeight = 0;
+    QImage atlas;
+};
+
+#endif // GLYPHATLAS_H
@@ -4,38 +4,72 @@
 #include <QDebug>
 #include "MyOpenGLWidget.h"
 
+// Запрос состояния только видимой области. Запас — на то, что успевает
+// въехать в кадр за время опроса и задержку интерполяции.
+static QByteArray stateRequest(const MyOpenGLWidget& widget)
+{
+    QRectF view = widget.viewRect(1.0f);
+    return QByteArray("get_state ") + QByteArray::number(view.left()) + ' '
+           + QByteArray::number(view.top()) + ' ' + QByteArray::number(view.right()) + ' '
+           + QByteArray::number(view.bottom());
+}
+
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
 
+    // --stream: подписка на дельты вместо опроса get_state
+    bool stream = app.arguments().contains("--stream");
+
     MyOpenGLWidget widget;
     widget.resize(800, 600);
     widget.show();
 
     QTcpSocket* socket = new QTcpSocket(&app);
+    QByteArray received;
 
-    // 1. Получаем данные от сервера и обновляем сцену
+    // 1. Получаем данные от сервера и обновляем сцену. Каждое сообщение
+    //    сервера заканчивается '\n', большое состояние может прийти частями.
     QObject::connect(socket, &QTcpSocket::readyRead, [&]() {
-        QByteArray response = socket->readAll();
-        qDebug() << "[GUI] Получен ответ от сервера (size:" << response.size() << "):" << response;
-        widget.updateSceneFromJson(response);
+        received.append(socket->readAll());
+        int offset = 0;
+        int newline;
+        while ((newline = received.indexOf('\n', offset)) >= 0) {
+            QByteArray message = received.mid(offset, newline - offset);
+            offset = newline + 1;
+            if (stream) {
+                widget.applyStateDelta(message);
+            } else {
+                qDebug() << "[GUI] Получен ответ от сервера (size:" << message.size() << ")";
+                widget.updateSceneFromJson(message);
+            }
+        }
+        received.remove(0, offset);
     });
 
     // 2. После подключения сразу запросить состояние сцены
     QObject::connect(socket, &QTcpSocket::connected, [&]() {
-        qDebug() << "[GUI] Отправлен запрос get_state";
-        socket->write("get_state");
+        if (stream) {
+            qDebug() << "[GUI] Отправлена подписка на дельты";
+            socket->write("subscribe");
+        } else {
+            qDebug() << "[GUI] Отправлен запрос get_state";
+            socket->write(stateRequest(widget));
+        }
         socket->flush();
     });
 
-    // 3. Периодически запрашиваем состояние (например, раз в 300 мс)
+    // 3. Периодически запрашиваем состояние (10 Гц, плавность даёт интерполяция);
+    //    в режиме подписки сервер присылает изменения сам
     QTimer* timer = new QTimer(&app);
-    QObject::connect(timer, &QTimer::timeout, [=]() {
+    QObject::connect(timer, &QTimer::timeout, [&widget, socket]() {
         qDebug() << "[GUI] Отправлен запрос get_state";
-        socket->write("get_state");
+        socket->write(stateRequest(widget));
         socket->flush();
     });
-    timer->start(300);
+    if (!stream) {
+        timer->start(100);
+    }
 
     socket->connectToHost("127.0.0.1", 12345);
 
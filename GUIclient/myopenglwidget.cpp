@@ -1,17 +1,40 @@
 #include "MyOpenGLWidget.h"
-#include <QPainter>
 #include <QDebug>
 #include <QKeyEvent>
+#include <algorithm>
+#include <cstdio>
 
 
 MyOpenGLWidget::MyOpenGLWidget(QWidget* parent)
     : QOpenGLWidget(parent)
-{}
+{
+    // Все PNG декодируются и упаковываются здесь, до первого кадра
+    atlas.build(":/textures");
+    QFont labelFont;
+    labelFont.setPixelSize(LABEL_PIXEL_SIZE);
+    glyphs.build(labelFont, "0123456789.-+e:HP naif");
+    clock.start();
+    // Перерисовка с частотой экрана, а не с частотой сообщений сервера
+    connect(this, &QOpenGLWidget::frameSwapped, this, QOverload<>::of(&QWidget::update));
+}
+
+MyOpenGLWidget::~MyOpenGLWidget()
+{
+    // GL-ресурсы освобождаются при текущем контексте
+    makeCurrent();
+    sprites.deleteTexture(atlasTexture);
+    sprites.deleteTexture(glyphTexture);
+    sprites.destroy();
+    doneCurrent();
+}
 
 void MyOpenGLWidget::initializeGL()
 {
     initializeOpenGLFunctions();
     glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+    sprites.initialize();
+    atlasTexture = sprites.createTexture(atlas.image());
+    glyphTexture = sprites.createTexture(glyphs.image());
 }
 
 void MyOpenGLWidget::resizeGL(int w, int h)
@@ -23,72 +46,260 @@ void MyOpenGLWidget::paintGL()
 {
     glClear(GL_COLOR_BUFFER_BIT);
 
-    QPainter painter(this);
-    for (const GuiEntity& e : entities) {
-        drawEntity(e, painter);
+    qint64 renderTime = clock.elapsed() - INTERPOLATION_DELAY_MS;
+
+    QRectF view = viewRect();
+    sprites.begin(cameraZoom);
+    for (auto it = entities.begin(); it != entities.end();) {
+        const GuiEntity& e = it.value();
+        if (e.removedAt >= 0 && e.removedAt <= renderTime) {
+            it = entities.erase(it);
+            continue;
+        }
+        // ещё не появилась на отстающей шкале времени
+        if (e.historySize == 0 || e.history[0].time <= renderTime) {
+            QPointF position = sampledPosition(e, renderTime);
+            if (isVisible(e, position, view)) {
+                drawEntity(e, position);
+            }
+        }
+        ++it;
     }
-    painter.end();
+    // спрайты, подписи и полоски HP — по вызову отрисовки на каждое
+    sprites.end();
 }
 
-void MyOpenGLWidget::drawEntity(const GuiEntity& entity,  QPainter& painter)
+QRectF MyOpenGLWidget::viewRect(float margin) const
 {
-    int centerX = int(width() * (0.5f + entity.x / cameraZoom));
-    int centerY = int(height() * (0.5f - entity.y / cameraZoom));
+    float half = cameraZoom / 2 + margin;
+    return QRectF(-half, -half, 2 * half, 2 * half);
+}
 
-    QImage img;
-    if (!textures.contains(entity.texture)) {
-        img = QImage(":/textures/" + entity.texture); // Путь к ресурсам
-        textures[entity.texture] = img;
-    } else {
-        img = textures[entity.texture];
+bool MyOpenGLWidget::isVisible(const GuiEntity& entity, QPointF position, const QRectF& view) const
+{
+    // подпись шире спрайта и висит над полоской HP, её размер — в пикселях
+    float labelHeight = glyphs.height() * cameraZoom / float(height());
+    float labelHalfWidth = entity.hpLabel.width * cameraZoom / float(width()) / 2;
+    float halfWidth = std::max(entity.width / 2, labelHalfWidth);
+    float top = entity.height / 2 + HP_BAR_GAP * 2 + HP_BAR_HEIGHT + labelHeight;
+    float bottom = entity.height / 2;
+    if (entity.textureId == TextureAtlas::FALLBACK) {
+        bottom = std::max(bottom, entity.width / 2);
     }
-    if (!img.isNull()) {
-        // Масштабируем img так, чтобы он занял mesh.width × mesh.height в игровых координатах
-        float scaleX = entity.width / img.width();
-        float scaleY = entity.height / img.height();
-
-        // Размеры на экране, учитывая камеру
-        float drawW = entity.width / cameraZoom * width();
-        float drawH = entity.height / cameraZoom * height();
-
-        QRectF target(
-            centerX - drawW/2,
-            centerY - drawH/2,
-            drawW,
-            drawH
-            );
-        painter.drawImage(target, img);
-    } else {
+    // y растёт вверх, как в мире
+    return position.x() + halfWidth >= view.left() && position.x() - halfWidth <= view.right() &&
+           position.y() + top >= view.top() && position.y() - bottom <= view.bottom();
+}
+
+void MyOpenGLWidget::updateHpLabel(GuiEntity& entity)
+{
+    HpLabel& label = entity.hpLabel;
+    if (label.length > 0 && label.hp == entity.hp) return;
+
+    label.hp = entity.hp;
+    label.length = std::max(0, std::snprintf(label.text, sizeof(label.text), "HP: %g", entity.hp));
+    label.length = std::min(label.length, int(sizeof(label.text)) - 1);
+    label.width = 0;
+    for (int i = 0; i < label.length; ++i) {
+        label.width += glyphs.glyph(label.text[i]).advance;
+    }
+}
+
+
+qint64 MyOpenGLWidget::beginMessage()
+{
+    qint64 now = clock.elapsed();
+    previousMessageTime = lastMessageTime;
+    lastMessageTime = now;
+    ++messageCount;
+    return now;
+}
+
+GuiEntity& MyOpenGLWidget::upsertEntity(int id)
+{
+    auto it = entities.find(id);
+    if (it == entities.end() || it.value().removedAt >= 0) {
+        // новая сущность или id переиспользован после удаления
+        GuiEntity ge{};
+        ge.id = id;
+        it = entities.insert(id, ge);
+    }
+    it.value().lastMessage = messageCount;
+    return it.value();
+}
+
+static void pushSample(GuiEntity& entity, const PositionSample& sample)
+{
+    // два сообщения за одну миллисекунду: остаётся последнее
+    if (entity.historySize > 0 && entity.history[entity.historySize - 1].time == sample.time) {
+        entity.history[entity.historySize - 1] = sample;
+        return;
+    }
+    if (entity.historySize == GuiEntity::HISTORY_SIZE) {
+        std::copy(entity.history + 1, entity.history + GuiEntity::HISTORY_SIZE, entity.history);
+        --entity.historySize;
+    }
+    entity.history[entity.historySize++] = sample;
+}
+
+void MyOpenGLWidget::recordPosition(GuiEntity& entity, qint64 now, float x, float y)
+{
+    entity.x = x;
+    entity.y = y;
+    if (entity.historySize > 0) {
+        // В дельтах неподвижные сущности не приходят: если сущность молчала,
+        // на момент предыдущего сообщения она ещё стояла на старом месте
+        PositionSample last = entity.history[entity.historySize - 1];
+        if (last.time < previousMessageTime) {
+            pushSample(entity, {previousMessageTime, last.x, last.y});
+        }
+    }
+    pushSample(entity, {now, x, y});
+}
+
+QPointF MyOpenGLWidget::sampledPosition(const GuiEntity& entity, qint64 renderTime) const
+{
+    int n = entity.historySize;
+    if (n == 0) return QPointF(entity.x, entity.y);
+
+    const PositionSample* h = entity.history;
+    if (renderTime <= h[0].time) return QPointF(h[0].x, h[0].y);
+
+    for (int i = 1; i < n; ++i) {
+        if (renderTime <= h[i].time) {
+            float t = float(renderTime - h[i - 1].time) / float(h[i].time - h[i - 1].time);
+            return QPointF(h[i - 1].x + (h[i].x - h[i - 1].x) * t,
+                           h[i - 1].y + (h[i].y - h[i - 1].y) * t);
+        }
+    }
+
+    // Позже последнего положения. Если с тех пор приходили сообщения без
+    // этой сущности — она стоит. Иначе новых данных ещё нет: экстраполируем
+    // по последней скорости, но недалеко.
+    const PositionSample& last = h[n - 1];
+    if (n < 2 || last.time < lastMessageTime) return QPointF(last.x, last.y);
+
+    const PositionSample& prev = h[n - 2];
+    float dt = float(std::min(renderTime - last.time, MAX_EXTRAPOLATION_MS));
+    float span = float(last.time - prev.time);
+    if (span <= 0.0f) return QPointF(last.x, last.y);
+    return QPointF(last.x + (last.x - prev.x) / span * dt,
+                   last.y + (last.y - prev.y) / span * dt);
+}
+
+void MyOpenGLWidget::drawEntity(const GuiEntity& entity, QPointF position)
+{
+    auto x = float(position.x());
+    auto y = float(position.y());
+
+    // Спрайт занимает mesh.width × mesh.height в игровых координатах,
+    // масштабирует его GPU, а не QImage::scaled на CPU.
+    // Все спрайты в одном атласе — один вызов отрисовки на всех.
+    const QRectF& uv = atlas.uv(entity.textureId);
+    if (entity.textureId == TextureAtlas::FALLBACK) {
         // fallback — кружок такого же размера
-        float drawR = entity.width / cameraZoom * width() / 2;
-        painter.setBrush(Qt::red);
-        painter.drawEllipse(QPointF(centerX, centerY), drawR, drawR);
+        sprites.drawSprite(atlasTexture, x, y, entity.width, entity.width, uv);
+    } else {
+        sprites.drawSprite(atlasTexture, x, y, entity.width, entity.height, uv);
+    }
+
+    // Полоска HP над спрайтом: подложка и заполненная часть
+    if (entity.maxHp > 0.0f) {
+        float fraction = std::clamp(entity.hp / entity.maxHp, 0.0f, 1.0f);
+        float barY = y + entity.height / 2 + HP_BAR_GAP + HP_BAR_HEIGHT / 2;
+        sprites.drawRect(x, barY, entity.width, HP_BAR_HEIGHT, QColor(40, 40, 40, 200));
+        float fillWidth = entity.width * fraction;
+        sprites.drawRect(x - entity.width / 2 + fillWidth / 2, barY, fillWidth, HP_BAR_HEIGHT, QColor(220, 30, 30));
     }
 
+    // У стен нет HP — и подписи тоже
+    if (entity.maxHp <= 0.0f) return;
 
-    painter.setPen(Qt::red);
-    painter.drawText(centerX - 10, centerY - 25, QString("HP: %1").arg(entity.hp));
+    // Подпись над полоской: размер в пикселях постоянный при любом зуме
+    const HpLabel& label = entity.hpLabel;
+    float pixelX = cameraZoom / float(width());
+    float pixelY = cameraZoom / float(height());
+    float glyphHeight = glyphs.height() * pixelY;
+    float penX = x - label.width * pixelX / 2;
+    float textY = y + entity.height / 2 + HP_BAR_GAP * 2 + HP_BAR_HEIGHT + glyphHeight / 2;
+    for (int i = 0; i < label.length; ++i) {
+        const GlyphAtlas::Glyph& glyph = glyphs.glyph(label.text[i]);
+        if (!glyph.valid) continue;
+        float glyphWidth = glyph.advance * pixelX;
+        sprites.drawSprite(glyphTexture, penX + glyphWidth / 2, textY, glyphWidth, glyphHeight,
+                           glyph.uv, QColor(Qt::red));
+        penX += glyphWidth;
+    }
 }
 
 void MyOpenGLWidget::updateSceneFromJson(const QByteArray& data)
 {
-    entities.clear();
+    qint64 now = beginMessage();
     try {
-        nlohmann::json j = nlohmann::json::parse(data.toStdString());
+        nlohmann::json j = nlohmann::json::parse(data.constData(), data.constData() + data.size());
         for (const auto& e : j["entities"]) {
-            GuiEntity ge;
-            ge.id = e.value("id", 0);
+            GuiEntity& ge = upsertEntity(e.value("id", 0));
             ge.type = QString::fromStdString(e.value("type", ""));
-            ge.x = e.value("x", 0.0f);
-            ge.y = e.value("y", 0.0f);
             ge.hp = e.value("hp", 0.0f);
-            ge.texture = QString::fromStdString(e.value("texture", ""));
+            ge.maxHp = std::max(ge.maxHp, ge.hp);
+            updateHpLabel(ge);
+            QString texture = QString::fromStdString(e.value("texture", ""));
+            if (texture != ge.texture || ge.textureId == TextureAtlas::FALLBACK) {
+                ge.texture = texture;
+                ge.textureId = atlas.find(texture);
+            }
             ge.width = e.value("width", 0.0f);
             ge.height = e.value("height", 0.0f);
-            entities.push_back(ge);
+            recordPosition(ge, now, e.value("x", 0.0f), e.value("y", 0.0f));
+        }
+        // Полный снимок: кого в нём нет, того больше нет
+        for (GuiEntity& ge : entities) {
+            if (ge.lastMessage != messageCount && ge.removedAt < 0) {
+                ge.removedAt = now;
+            }
         }
     } catch (...) {
         qDebug() << "Ошибка парсинга JSON для GUI";
     }
     update(); // Перерисовать сцену
 }
+
+void MyOpenGLWidget::applyStateDelta(const QByteArray& data)
+{
+    try {
+        nlohmann::json j = nlohmann::json::parse(data.constData(), data.constData() + data.size());
+        qint64 now = beginMessage();
+        // Удаление видно, когда до этого момента дойдёт отстающая шкала отрисовки
+        for (const auto& id : j["remove"]) {
+            auto it = entities.find(id.get<int>());
+            if (it != entities.end()) {
+                it.value().removedAt = now;
+            }
+        }
+        for (const auto& e : j["upsert"]) {
+            // Новая сущность приходит целиком, изменённая — только своими полями
+            GuiEntity& ge = upsertEntity(e.at("id").get<int>());
+            if (e.contains("texture")) {
+                // полная запись: id мог достаться другой сущности
+                ge.historySize = 0;
+                ge.maxHp = 0;
+            }
+            ge.type = e.contains("type") ? QString::fromStdString(e["type"].get<std::string>()) : ge.type;
+            if (e.contains("x")) {
+                recordPosition(ge, now, e.value("x", ge.x), e.value("y", ge.y));
+            }
+            ge.hp = e.value("hp", ge.hp);
+            ge.maxHp = std::max(ge.maxHp, ge.hp);
+            updateHpLabel(ge);
+            if (e.contains("texture")) {
+                ge.texture = QString::fromStdString(e["texture"].get<std::string>());
+                ge.textureId = atlas.find(ge.texture);
+            }
+            ge.width = e.value("width", ge.width);
+            ge.height = e.value("height", ge.height);
+        }
+    } catch (...) {
+        qDebug() << "Ошибка парсинга дельты состояния";
+    }
+    update();
+}
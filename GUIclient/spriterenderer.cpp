@@ -0,0 +1,229 @@
+#include "spriterenderer.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstddef>
+
+namespace {
+
+// GLSL 1.00: понимают и desktop GL 2.1 (compatibility), и ES 2.0
+const char* vertexShaderSource = R"(
+attribute vec2 position;
+attribute vec2 texCoord;
+attribute vec4 color;
+uniform float scale;
+varying vec2 vTexCoord;
+varying vec4 vColor;
+void main() {
+    gl_Position = vec4(position * scale, 0.0, 1.0);
+    vTexCoord = texCoord;
+    vColor = color;
+}
+)";
+
+const char* fragmentShaderSource = R"(
+#ifdef GL_ES
+precision mediump float;
+#endif
+uniform sampler2D sprite;
+varying vec2 vTexCoord;
+varying vec4 vColor;
+void main() {
+    gl_FragColor = texture2D(sprite, vTexCoord) * vColor;
+}
+)";
+
+enum AttributeLocation { POSITION = 0, TEX_COORD = 1, COLOR = 2 };
+
+}
+
+void SpriteRenderer::initialize()
+{
+    initializeOpenGLFunctions();
+
+    program.addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShaderSource);
+    program.addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShaderSource);
+    program.bindAttributeLocation("position", POSITION);
+    program.bindAttributeLocation("texCoord", TEX_COORD);
+    program.bindAttributeLocation("color", COLOR);
+    if (!program.link()) {
+        qDebug() << "Не удалось собрать шейдер спрайтов:" << program.log();
+    }
+
+    // VAO может не быть на чистом GL 2.1 — тогда атрибуты задаются при каждом вызове
+    vao.create();
+
+    vertexBuffer.create();
+    vertexBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+
+    // Индексы квадов одинаковы для всех кадров: 0 1 2, 2 3 0, ...
+    std::vector<GLushort> indices(std::size_t(MAX_QUADS_PER_DRAW) * 6);
+    for (int quad = 0; quad < MAX_QUADS_PER_DRAW; ++quad) {
+        GLushort base = GLushort(quad * 4);
+        GLushort* out = &indices[std::size_t(quad) * 6];
+        out[0] = base; out[1] = GLushort(base + 1); out[2] = GLushort(base + 2);
+        out[3] = GLushort(base + 2); out[4] = GLushort(base + 3); out[5] = base;
+    }
+    indexBuffer.create();
+    indexBuffer.bind();
+    indexBuffer.allocate(indices.data(), int(indices.size() * sizeof(GLushort)));
+    indexBuffer.release();
+
+    QImage whitePixel(1, 1, QImage::Format_RGBA8888);
+    whitePixel.fill(Qt::white);
+    white = createTexture(whitePixel);
+
+    initialized = true;
+}
+
+void SpriteRenderer::destroy()
+{
+    if (!initialized) return;
+    // текстуры спрайтов удаляет тот, кто их создал
+    deleteTexture(white);
+    white = 0;
+    vertexBuffer.destroy();
+    indexBuffer.destroy();
+    vao.destroy();
+    program.removeAllShaders();
+    batches.clear();
+    initialized = false;
+}
+
+GLuint SpriteRenderer::createTexture(const QImage& image)
+{
+    if (image.isNull()) return 0;
+    QImage rgba = image.convertToFormat(QImage::Format_RGBA8888);
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    // без мипмапов и с CLAMP_TO_EDGE, чтобы NPOT-текстуры работали и на ES 2.0
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // строки идут сверху вниз: v = 0 — верх картинки
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, rgba.width(), rgba.height(), 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, rgba.constBits());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+void SpriteRenderer::deleteTexture(GLuint texture)
+{
+    if (texture != 0) {
+        glDeleteTextures(1, &texture);
+    }
+}
+
+void SpriteRenderer::begin(float cameraZoom)
+{
+    scale = 2.0f / cameraZoom;
+    for (Batch& batch : batches) {
+        batch.vertices.clear();
+    }
+}
+
+SpriteRenderer::Batch& SpriteRenderer::batchFor(GLuint texture)
+{
+    // текстур единицы, линейный поиск быстрее любой хеш-таблицы
+    for (Batch& batch : batches) {
+        if (batch.texture == texture) return batch;
+    }
+    batches.push_back({texture, {}});
+    return batches.back();
+}
+
+void SpriteRenderer::appendQuad(Batch& batch, float cx, float cy, float w, float h,
+                                const QRectF& uv, const QColor& color)
+{
+    float left = cx - w / 2;
+    float right = cx + w / 2;
+    float top = cy + h / 2;    // мировой y растёт вверх
+    float bottom = cy - h / 2;
+    auto u0 = float(uv.left());
+    auto u1 = float(uv.right());
+    auto v0 = float(uv.top());
+    auto v1 = float(uv.bottom());
+    auto r = std::uint8_t(color.red());
+    auto g = std::uint8_t(color.green());
+    auto b = std::uint8_t(color.blue());
+    auto a = std::uint8_t(color.alpha());
+
+    batch.vertices.push_back({left, top, u0, v0, r, g, b, a});
+    batch.vertices.push_back({right, top, u1, v0, r, g, b, a});
+    batch.vertices.push_back({right, bottom, u1, v1, r, g, b, a});
+    batch.vertices.push_back({left, bottom, u0, v1, r, g, b, a});
+}
+
+void SpriteRenderer::drawSprite(GLuint texture, float cx, float cy, float w, float h,
+                                const QRectF& uv, const QColor& tint)
+{
+    appendQuad(batchFor(texture), cx, cy, w, h, uv, tint);
+}
+
+void SpriteRenderer::drawRect(float cx, float cy, float w, float h, const QColor& color)
+{
+    appendQuad(batchFor(white), cx, cy, w, h, QRectF(0, 0, 1, 1), color);
+}
+
+void SpriteRenderer::end()
+{
+    lastDrawCalls = 0;
+    lastQuads = 0;
+    if (!initialized || !program.isLinked()) return;
+
+    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    program.bind();
+    program.setUniformValue("scale", scale);
+    program.setUniformValue("sprite", 0);
+    glActiveTexture(GL_TEXTURE0);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    const Batch* rects = nullptr;
+    for (const Batch& batch : batches) {
+        if (batch.texture == white) {
+            rects = &batch;
+            continue;
+        }
+        drawBatch(batch);
+    }
+    if (rects) {
+        drawBatch(*rects);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    program.disableAttributeArray(POSITION);
+    program.disableAttributeArray(TEX_COORD);
+    program.disableAttributeArray(COLOR);
+    program.release();
+    vertexBuffer.release();
+    indexBuffer.release();
+}
+
+void SpriteRenderer::drawBatch(const Batch& batch)
+{
+    int quadCount = int(batch.vertices.size() / 4);
+    if (quadCount == 0) return;
+
+    glBindTexture(GL_TEXTURE_2D, batch.texture);
+    vertexBuffer.bind();
+    vertexBuffer.allocate(batch.vertices.data(), int(batch.vertices.size() * sizeof(Vertex)));
+    indexBuffer.bind();
+    program.enableAttributeArray(POSITION);
+    program.enableAttributeArray(TEX_COORD);
+    program.enableAttributeArray(COLOR);
+
+    for (int first = 0; first < quadCount; first += MAX_QUADS_PER_DRAW) {
+        int count = std::min(MAX_QUADS_PER_DRAW, quadCount - first);
+        int offset = first * 4 * int(sizeof(Vertex));
+        program.setAttributeBuffer(POSITION, GL_FLOAT, offset + int(offsetof(Vertex, x)), 2, sizeof(Vertex));
+        program.setAttributeBuffer(TEX_COORD, GL_FLOAT, offset + int(offsetof(Vertex, u)), 2, sizeof(Vertex));
+        // GL_UNSIGNED_BYTE нормализуется в 0..1
+        program.setAttributeBuffer(COLOR, GL_UNSIGNED_BYTE, offset + int(offsetof(Vertex, r)), 4, sizeof(Vertex));
+        glDrawElements(GL_TRIANGLES, count * 6, GL_UNSIGNED_SHORT, nullptr);
+        ++lastDrawCalls;
+    }
+    lastQuads += quadCount;
+}
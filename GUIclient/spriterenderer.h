@@ -0,0 +1,77 @@
+#ifndef SPRITERENDERER_H
+#define SPRITERENDERER_H
+
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLBuffer>
+#include <QOpenGLVertexArrayObject>
+#include <QImage>
+#include <QRectF>
+#include <QColor>
+#include <vector>
+#include <cstdint>
+
+// Пакетная отрисовка спрайтов и цветных прямоугольников.
+// Квады копятся в массивы по текстурам и уходят одним glDrawElements на
+// текстуру (до 16k квадов за вызов — предел 16-битных индексов ES 2.0).
+// Шейдеры GLSL 1.00 без инстансинга, поэтому работает на GL 2.1/ES 2.0,
+// в том числе на llvmpipe из Mesa при headless-прогонах.
+class SpriteRenderer : protected QOpenGLFunctions
+{
+public:
+    // Вызывать при текущем GL-контексте (initializeGL / деструктор виджета)
+    void initialize();
+    void destroy();
+
+    // Загружает картинку в GL-текстуру; 0 — картинка пустая
+    GLuint createTexture(const QImage& image);
+    void deleteTexture(GLuint texture);
+    // Белый пиксель: с ним спрайт становится прямоугольником цвета tint
+    GLuint whiteTexture() const { return white; }
+
+    // Мировые координаты переводятся в экранные так же, как раньше в QPainter:
+    // центр окна — (0, 0), по cameraZoom мировых единиц на ширину и высоту
+    void begin(float cameraZoom);
+    void drawSprite(GLuint texture, float cx, float cy, float w, float h,
+                    const QRectF& uv = QRectF(0, 0, 1, 1), const QColor& tint = QColor(255, 255, 255));
+    void drawRect(float cx, float cy, float w, float h, const QColor& color);
+    // Рисует накопленное: сначала спрайты, потом прямоугольники поверх них
+    void end();
+
+    int drawCalls() const { return lastDrawCalls; }
+    int quads() const { return lastQuads; }
+
+private:
+    struct Vertex {
+        float x, y;
+        float u, v;
+        std::uint8_t r, g, b, a;
+    };
+
+    struct Batch {
+        GLuint texture;
+        std::vector<Vertex> vertices;
+    };
+
+    static constexpr int MAX_QUADS_PER_DRAW = 65536 / 4;
+
+    Batch& batchFor(GLuint texture);
+    void appendQuad(Batch& batch, float cx, float cy, float w, float h,
+                    const QRectF& uv, const QColor& color);
+    void drawBatch(const Batch& batch);
+
+    QOpenGLShaderProgram program;
+    QOpenGLBuffer vertexBuffer{QOpenGLBuffer::VertexBuffer};
+    QOpenGLBuffer indexBuffer{QOpenGLBuffer::IndexBuffer};
+    QOpenGLVertexArrayObject vao;
+    GLuint white = 0;
+
+    // Пакеты живут между кадрами, чтобы не перевыделять память
+    std::vector<Batch> batches;
+    float scale = 0.2f;
+    int lastDrawCalls = 0;
+    int lastQuads = 0;
+    bool initialized = false;
+};
+
+#endif // SPRITERENDERER_H
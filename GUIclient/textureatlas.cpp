@@ -0,0 +1,116 @@
+#include "textureatlas.h"
+#include <QDirIterator>
+#include <QPainter>
+#include <QDebug>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+// Прозрачный зазор между картинками, чтобы линейная фильтрация
+// не подмешивала соседей
+const int PADDING = 2;
+
+QImage fallbackCircle()
+{
+    QImage circle(64, 64, QImage::Format_RGBA8888);
+    circle.fill(Qt::transparent);
+    QPainter painter(&circle);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(Qt::red);
+    painter.drawEllipse(QPointF(32, 32), 31, 31);
+    painter.end();
+    return circle;
+}
+
+}
+
+TextureAtlas::TextureAtlas()
+{
+    regions.push_back({QString(), fallbackCircle(), QRectF()});
+}
+
+bool TextureAtlas::build(const QString& resourceDir, int maxSize)
+{
+    QDirIterator it(resourceDir, QDir::Files);
+    while (it.hasNext()) {
+        it.next();
+        QImage image(it.filePath());
+        if (image.isNull()) {
+            qDebug() << "Не удалось загрузить текстуру" << it.filePath();
+            continue;
+        }
+        if (std::max(image.width(), image.height()) > MAX_SPRITE_EDGE) {
+            image = image.scaled(MAX_SPRITE_EDGE, MAX_SPRITE_EDGE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+        ids.insert(it.fileName(), TextureId(regions.size()));
+        regions.push_back({it.fileName(), image, QRectF()});
+    }
+
+    // Меньший атлас — меньше памяти; растём, пока всё не влезет:
+    // 256x128, 256x256, 512x256, ...
+    for (int atlasWidth = 256; atlasWidth <= maxSize; atlasWidth *= 2) {
+        for (int atlasHeight : {atlasWidth / 2, atlasWidth}) {
+            if (!pack(atlasWidth, atlasHeight)) continue;
+            qDebug() << "Атлас текстур:" << regions.size() << "картинок," << atlasWidth << "x" << atlasHeight;
+            for (Region& region : regions) {
+                region.source = QImage();
+            }
+            return true;
+        }
+    }
+    qDebug() << "Текстуры не помещаются в атлас" << maxSize << "x" << maxSize;
+    return false;
+}
+
+// Полки: картинки по убыванию высоты кладутся слева направо,
+// новая полка начинается, когда текущая заполнена
+bool TextureAtlas::pack(int atlasWidth, int atlasHeight)
+{
+    std::vector<std::size_t> order(regions.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) {
+        return regions[a].source.height() > regions[b].source.height();
+    });
+
+    std::vector<QPoint> positions(regions.size());
+    int x = 0;
+    int y = 0;
+    int shelfHeight = 0;
+    for (std::size_t index : order) {
+        const QImage& image = regions[index].source;
+        int w = image.width() + PADDING;
+        int h = image.height() + PADDING;
+        if (x + w > atlasWidth) {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = 0;
+        }
+        if (x + w > atlasWidth || y + h > atlasHeight) return false;
+        positions[index] = QPoint(x, y);
+        x += w;
+        shelfHeight = std::max(shelfHeight, h);
+    }
+
+    atlas = QImage(atlasWidth, atlasHeight, QImage::Format_RGBA8888);
+    atlas.fill(Qt::transparent);
+    QPainter painter(&atlas);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    for (std::size_t i = 0; i < regions.size(); ++i) {
+        const QImage& image = regions[i].source;
+        painter.drawImage(positions[i], image);
+        // полтекселя внутрь, чтобы выборка не задевала зазор
+        regions[i].uv = QRectF((positions[i].x() + 0.5) / atlasWidth,
+                               (positions[i].y() + 0.5) / atlasHeight,
+                               (image.width() - 1.0) / atlasWidth,
+                               (image.height() - 1.0) / atlasHeight);
+    }
+    painter.end();
+    return true;
+}
+
+TextureId TextureAtlas::find(const QString& name) const
+{
+    return ids.value(name, FALLBACK);
+}
@@ -0,0 +1,56 @@
+#ifndef TEXTUREATLAS_H
+#define TEXTUREATLAS_H
+
+#include <QImage>
+#include <QRectF>
+#include <QString>
+#include <QHash>
+#include <vector>
+#include <cstdint>
+
+using TextureId = std::uint16_t;
+
+// Все текстуры клиента в одной картинке. Собирается один раз при старте:
+// PNG декодируются до первого кадра, а при отрисовке спрайт — это индекс
+// в массив UV-прямоугольников, без поиска по имени и копирования QImage.
+class TextureAtlas
+{
+public:
+    // Красный круг для текстур, которых нет в ресурсах
+    static constexpr TextureId FALLBACK = 0;
+    // Крупнее этого по длинной стороне картинки уменьшаются: на экране
+    // спрайт всё равно занимает от силы пару сотен пикселей
+    static constexpr int MAX_SPRITE_EDGE = 512;
+
+    TextureAtlas();
+
+    // Загружает и упаковывает все файлы из каталога ресурсов (":/textures").
+    // Имена интернируются в порядке обхода; false — не влезло в maxSize x maxSize.
+    bool build(const QString& resourceDir, int maxSize = 4096);
+
+    // id по имени файла текстуры; FALLBACK, если такой нет.
+    // Вызывать при получении имени от сервера, а не на каждом кадре.
+    TextureId find(const QString& name) const;
+
+    const QRectF& uv(TextureId id) const { return regions[id].uv; }
+    const QString& name(TextureId id) const { return regions[id].name; }
+    std::size_t size() const { return regions.size(); }
+
+    // Готовая картинка атласа (RGBA8888) для загрузки в GL
+    const QImage& image() const { return atlas; }
+
+private:
+    struct Region {
+        QString name;
+        QImage source;  // нужна только до упаковки
+        QRectF uv;
+    };
+
+    bool pack(int atlasWidth, int atlasHeight);
+
+    std::vector<Region> regions;
+    QHash<QString, TextureId> ids;
+    QImage atlas;
+};
+
+#endif // TEXTUREATLAS_H
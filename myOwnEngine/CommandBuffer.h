@@ -0,0 +1,117 @@
+#ifndef COMMANDBUFFER_H
+#define COMMANDBUFFER_H
+
+#include <vector>
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+#include <cstdint>
+#include "entity/Entity.h"
+#include "entity/EntityManager.h"
+#include "components/ComponentManager.h"
+
+// Буфер отложенных структурных изменений ECS.
+// Во время тика системы только записывают create/destroy/add/remove,
+// а Scene применяет их одной пачкой в точке синхронизации (конец update).
+// Так ни одна система не меняет System::entities и карты компонентов,
+// пока кто-то по ним итерируется.
+class CommandBuffer {
+private:
+    // Хранилище команд одного вида для одного типа компонента. Заводится
+    // при первой такой команде и живёт вместе с буфером: команда — индекс
+    // в векторе, а не замыкание в куче.
+    struct IPayloads {
+        virtual ~IPayloads() = default;
+        virtual void apply(ComponentManager& cm, Entity entity, std::uint32_t index) = 0;
+        virtual void clear() = 0;
+    };
+
+    template<typename T>
+    struct AddedComponents : IPayloads {
+        std::vector<T> components;
+
+        void apply(ComponentManager& cm, Entity entity, std::uint32_t index) override {
+            cm.addComponent<T>(entity, std::move(components[index]));
+        }
+        void clear() override { components.clear(); }
+    };
+
+    template<typename T>
+    struct RemovedComponents : IPayloads {
+        void apply(ComponentManager& cm, Entity entity, std::uint32_t) override {
+            cm.removeComponent<T>(entity);
+        }
+        void clear() override {}
+    };
+
+public:
+    enum class CommandType { ADD_COMPONENT, REMOVE_COMPONENT, DESTROY };
+
+    struct Command {
+        CommandType type;
+        Entity entity;
+        IPayloads* payloads;  // nullptr для DESTROY
+        std::uint32_t index;  // место компонента в payloads
+
+        void apply(ComponentManager& cm) const { payloads->apply(cm, entity, index); }
+    };
+
+    // Запас на одну команду на сущность: обычный тик (волна смертей)
+    // в него укладывается без перевыделений
+    explicit CommandBuffer(EntityManager& em) : entityManager(em) {
+        commands.reserve(MAX_ENTITIES);
+    }
+
+    // id выдаётся сразу (это не трогает ни системы, ни компоненты),
+    // компоненты новой сущности добавляются через addComponent
+    Entity createEntity() {
+        return entityManager.createEntity();
+    }
+
+    void destroyEntity(Entity entity) {
+        commands.push_back({CommandType::DESTROY, entity, nullptr, 0});
+    }
+
+    template<typename T>
+    void addComponent(Entity entity, T component) {
+        auto& added = payloadsFor<AddedComponents<T>>();
+        added.components.push_back(std::move(component));
+        commands.push_back({CommandType::ADD_COMPONENT, entity, &added,
+                            std::uint32_t(added.components.size() - 1)});
+    }
+
+    template<typename T>
+    void removeComponent(Entity entity) {
+        commands.push_back({CommandType::REMOVE_COMPONENT, entity,
+                            &payloadsFor<RemovedComponents<T>>(), 0});
+    }
+
+    bool empty() const { return commands.empty(); }
+
+    // Забирает накопленные команды; ёмкость вектора остаётся в буфере
+    void swap(std::vector<Command>& out) {
+        commands.swap(out);
+    }
+
+    // Все забранные команды применены: их компоненты больше не нужны.
+    // Ёмкость хранилищ остаётся до следующего тика.
+    void recycle() {
+        for (auto& [_, payloads] : payloadsByType) {
+            payloads->clear();
+        }
+    }
+
+private:
+    template<typename P>
+    P& payloadsFor() {
+        auto& slot = payloadsByType[std::type_index(typeid(P))];
+        if (!slot) slot = std::make_unique<P>();
+        return static_cast<P&>(*slot);
+    }
+
+    EntityManager& entityManager;
+    std::vector<Command> commands;
+    std::unordered_map<std::type_index, std::unique_ptr<IPayloads>> payloadsByType;
+};
+
+#endif // COMMANDBUFFER_H
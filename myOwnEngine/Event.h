@@ -3,17 +3,19 @@
 
 #include "entity/Entity.h"
 
+// База для пользовательских событий, которые идут через type_index-очереди EventBus.
+// Встроенные события ниже — простые POD-структуры со своим EventChannel.
 struct EventBase {
     virtual ~EventBase() = default;
 };
 
-struct EntityDiedEvent : EventBase {
+struct EntityDiedEvent {
     Entity entity;
     Entity killer;
     EntityDiedEvent(Entity e, Entity k = MAX_ENTITIES) : entity(e), killer(k) {}
 };
 
-struct HealthChangedEvent : EventBase {
+struct HealthChangedEvent {
     Entity entity;
     float oldHealth;
     float newHealth;
@@ -6,36 +6,175 @@
 #include <vector>
 #include <typeindex>
 #include <memory>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
 #include "Event.h"
+#include "EventChannel.h"
 
 
+// Встроенные события движка: у каждого свой EventChannel, выбираемый
+// на этапе компиляции. Новое встроенное событие добавляется в этот список.
+using EngineEventChannels = std::tuple<
+    EventChannel<EntityDiedEvent>,
+    EventChannel<HealthChangedEvent>
+>;
+
+template<typename EventT, typename Channels>
+struct HasEventChannel;
+
+template<typename EventT, typename... Channels>
+struct HasEventChannel<EventT, std::tuple<Channels...>>
+    : std::disjunction<std::is_same<EventChannel<EventT>, Channels>...> {};
+
+template<typename EventT>
+constexpr bool isEngineEvent = HasEventChannel<EventT, EngineEventChannels>::value;
+
 class EventBus {
 public:
     using HandlerFunc = std::function<void(const EventBase&)>;
 
+    template<typename EventT>
+    using BatchHandler = std::function<void(EventSpan<EventT>)>;
+
+    // Канал встроенного события; разрешается на этапе компиляции
+    template<typename EventT>
+    EventChannel<EventT>& channel() {
+        static_assert(isEngineEvent<EventT>, "Event type has no compile-time channel.");
+        return std::get<EventChannel<EventT>>(channels);
+    }
+
     template<typename EventT>
     void subscribe(std::function<void(const EventT&)> handler) {
-        auto typeIdx = std::type_index(typeid(EventT));
-        HandlerFunc wrapper = [handler](const EventBase& base) {
-            handler(static_cast<const EventT&>(base));
-        };
-        handlers[typeIdx].push_back(wrapper);
+        if constexpr (isEngineEvent<EventT>) {
+            channel<EventT>().connect(std::move(handler));
+        } else {
+            auto typeIdx = std::type_index(typeid(EventT));
+            HandlerFunc wrapper = [handler](const EventBase& base) {
+                handler(static_cast<const EventT&>(base));
+            };
+            handlers[typeIdx].push_back(wrapper);
+        }
+    }
+
+    // Подписка на пачку событий: вызывается один раз на тип за dispatchQueued()
+    template<typename EventT>
+    void subscribeBatch(BatchHandler<EventT> handler) {
+        static_assert(!isEngineEvent<EventT>, "Use channel<EventT>().connect for engine events.");
+        getQueue<EventT>().batchHandlers.push_back(std::move(handler));
     }
 
     // Публикация события (распространяет всем подписчикам)
     template<typename EventT>
     void publish(const EventT& event) {
-        auto typeIdx = std::type_index(typeid(EventT));
-        auto it = handlers.find(typeIdx);
-        if (it != handlers.end()) {
-            for (auto& handler : it->second) {
-                handler(event);
+        if constexpr (isEngineEvent<EventT>) {
+            channel<EventT>().deliverNow(event);
+        } else {
+            auto typeIdx = std::type_index(typeid(EventT));
+            auto it = handlers.find(typeIdx);
+            if (it != handlers.end()) {
+                for (auto& handler : it->second) {
+                    handler(event);
+                }
+            }
+            auto queueIt = queues.find(typeIdx);
+            if (queueIt != queues.end()) {
+                auto& queue = static_cast<EventQueue<EventT>&>(*queueIt->second);
+                for (auto& handler : queue.batchHandlers) {
+                    handler(EventSpan<EventT>{&event, 1});
+                }
+            }
+        }
+    }
+
+    // Отложенная публикация: событие копируется в типизированный массив
+    // и уходит подписчикам только в dispatchQueued() (конец тика)
+    template<typename EventT>
+    void enqueue(const EventT& event) {
+        if constexpr (isEngineEvent<EventT>) {
+            channel<EventT>().publish(event);
+        } else {
+            getQueue<EventT>().events.push_back(event);
+        }
+    }
+
+    // Раздаёт накопленные события: по одному вызову на тип для batch-подписчиков
+    // (сначала встроенные каналы, затем очереди пользовательских типов).
+    // События, добавленные обработчиками, раздаются в следующем проходе.
+    void dispatchQueued() {
+        bool pending = true;
+        while (pending) {
+            pending = false;
+            std::apply([&pending](auto&... channel) {
+                ((pending = channel.dispatch() || pending), ...);
+            }, channels);
+            // по индексу: обработчик может завести очередь нового типа
+            for (std::size_t i = 0; i < queueOrder.size(); ++i) {
+                IEventQueue* queue = queueOrder[i];
+                if (queue->empty()) continue;
+                auto it = handlers.find(queue->type);
+                queue->dispatch(it != handlers.end() ? &it->second : nullptr);
+                pending = true;
             }
         }
     }
+
 private:
+    EngineEventChannels channels;
+
+    class IEventQueue {
+    public:
+        explicit IEventQueue(std::type_index t) : type(t) {}
+        virtual ~IEventQueue() = default;
+        std::type_index type;
+        virtual bool empty() const = 0;
+        virtual void dispatch(const std::vector<HandlerFunc>* perEventHandlers) = 0;
+    };
+
+    template<typename EventT>
+    class EventQueue : public IEventQueue {
+    public:
+        EventQueue() : IEventQueue(std::type_index(typeid(EventT))) {}
+        std::vector<EventT> events;
+        std::vector<EventT> dispatching; // то, что раздаётся сейчас
+        std::vector<BatchHandler<EventT>> batchHandlers;
+
+        bool empty() const override { return events.empty(); }
+
+        void dispatch(const std::vector<HandlerFunc>* perEventHandlers) override {
+            dispatching.swap(events);
+            EventSpan<EventT> span{dispatching.data(), dispatching.size()};
+            for (auto& handler : batchHandlers) {
+                handler(span);
+            }
+            // старые подписчики на одиночные события тоже получают их
+            if (perEventHandlers) {
+                for (const auto& event : dispatching) {
+                    for (auto& handler : *perEventHandlers) {
+                        handler(event);
+                    }
+                }
+            }
+            dispatching.clear();
+        }
+    };
+
+    template<typename EventT>
+    EventQueue<EventT>& getQueue() {
+        auto& queue = queues[std::type_index(typeid(EventT))];
+        if (!queue) {
+            queue = std::make_unique<EventQueue<EventT>>();
+            queueOrder.push_back(queue.get());
+        }
+        return static_cast<EventQueue<EventT>&>(*queue);
+    }
+
     // тип события → массив подписчиков
     std::unordered_map<std::type_index, std::vector<HandlerFunc>> handlers;
+    // тип события → очередь отложенных событий и batch-подписчики
+    std::unordered_map<std::type_index, std::unique_ptr<IEventQueue>> queues;
+    // порядок раздачи — порядок регистрации типов (детерминированный)
+    std::vector<IEventQueue*> queueOrder;
 };
 
 
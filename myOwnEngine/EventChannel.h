@@ -0,0 +1,100 @@
+#ifndef EVENTCHANNEL_H
+#define EVENTCHANNEL_H
+
+#include <vector>
+#include <cstddef>
+#include <functional>
+
+
+// Непрерывный диапазон событий одного типа (аналог std::span)
+template<typename EventT>
+struct EventSpan {
+    const EventT* data = nullptr;
+    std::size_t count = 0;
+
+    const EventT* begin() const { return data; }
+    const EventT* end() const { return data + count; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const EventT& operator[](std::size_t i) const { return data[i]; }
+};
+
+// Статически типизированный канал событий: без EventBase, RTTI и std::function
+// на горячем пути. publish() — это push_back в вектор канала, подписчики
+// получают всю пачку за тик одним вызовом в dispatch().
+template<typename EventT>
+class EventChannel {
+public:
+    using Callback = void(*)(void* context, EventSpan<EventT> events);
+
+    // Подписка методом объекта; метод известен на этапе компиляции,
+    // поэтому внутри трамплина вызов прямой
+    template<auto Method, typename Owner>
+    void connect(Owner* owner) {
+        subscribers.push_back({owner, [](void* context, EventSpan<EventT> events) {
+            (static_cast<Owner*>(context)->*Method)(events);
+        }});
+    }
+
+    void connect(void* context, Callback callback) {
+        subscribers.push_back({context, callback});
+    }
+
+    // Медленный путь для подписчиков-лямбд на одиночные события
+    void connect(std::function<void(const EventT&)> handler) {
+        eventHandlers.push_back(std::move(handler));
+    }
+
+    // Отложенная публикация (до dispatch в конце тика)
+    void publish(const EventT& event) {
+        queue.push_back(event);
+    }
+
+    // Немедленная доставка одного события (не emit: в Qt это макрос)
+    void deliverNow(const EventT& event) {
+        deliver(EventSpan<EventT>{&event, 1});
+    }
+
+    bool empty() const { return queue.empty(); }
+
+    // Запас под столько событий за тик: пока его хватает, publish()
+    // кучу не трогает
+    void reserve(std::size_t count) {
+        queue.reserve(count);
+        dispatching.reserve(count);
+    }
+
+    // Раздаёт накопленное; события, опубликованные подписчиками,
+    // остаются в очереди до следующего вызова. false — раздавать было нечего.
+    bool dispatch() {
+        if (queue.empty()) return false;
+        dispatching.swap(queue);
+        deliver(EventSpan<EventT>{dispatching.data(), dispatching.size()});
+        dispatching.clear();
+        return true;
+    }
+
+private:
+    struct Subscriber {
+        void* context;
+        Callback callback;
+    };
+
+    void deliver(EventSpan<EventT> events) {
+        for (const auto& subscriber : subscribers) {
+            subscriber.callback(subscriber.context, events);
+        }
+        for (const auto& event : events) {
+            for (auto& handler : eventHandlers) {
+                handler(event);
+            }
+        }
+    }
+
+    std::vector<EventT> queue;
+    std::vector<EventT> dispatching;
+    std::vector<Subscriber> subscribers;
+    std::vector<std::function<void(const EventT&)>> eventHandlers;
+};
+
+#endif // EVENTCHANNEL_H
@@ -0,0 +1,102 @@
+#ifndef ASSETREGISTRY_H
+#define ASSETREGISTRY_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+#include <limits>
+#include "assets/NameTable.h"
+#include "point/point.h"
+#include "meshUtils.h"
+
+using TextureId = NameId;
+using MeshId = std::uint16_t;
+
+// Локальные границы меша (относительно центра сущности)
+struct MeshBounds {
+    float minX, maxX, minY, maxY;
+    float width() const { return maxX - minX; }
+    float height() const { return maxY - minY; }
+};
+
+// Неизменяемая геометрия, общая для всех сущностей с одинаковым мешем
+struct MeshAsset {
+    std::vector<Point> vertices;
+    MeshBounds bounds;
+};
+
+// Общие ресурсы сцены, на которые компоненты ссылаются по id
+class AssetRegistry {
+public:
+    TextureId internTexture(const std::string& name) {
+        return textures.intern(name);
+    }
+
+    const std::string& textureName(TextureId id) const {
+        return textures.name(id);
+    }
+
+    // Прямоугольник w×h с центром в нуле; одинаковые размеры дают один и тот же id
+    MeshId internRectangle(float width, float height) {
+        for (MeshId id = 0; id < rectangleSizes.size(); ++id) {
+            if (sameBits(rectangleSizes[id].x, width) && sameBits(rectangleSizes[id].y, height)) {
+                return rectangleIds[id];
+            }
+        }
+        MeshId id = addMesh(makeRectangleMesh(width, height));
+        rectangleSizes.push_back({width, height});
+        rectangleIds.push_back(id);
+        return id;
+    }
+
+    MeshId addMesh(std::vector<Point> vertices) {
+        assert(meshes.size() < std::numeric_limits<MeshId>::max() && "Mesh registry is full.");
+        MeshAsset asset;
+        asset.bounds = computeBounds(vertices);
+        asset.vertices = std::move(vertices);
+        meshes.push_back(std::move(asset));
+        return static_cast<MeshId>(meshes.size() - 1);
+    }
+
+    const MeshAsset& mesh(MeshId id) const {
+        assert(id < meshes.size() && "Unknown mesh id.");
+        return meshes[id];
+    }
+
+    const MeshBounds& meshBounds(MeshId id) const {
+        return mesh(id).bounds;
+    }
+
+private:
+    static bool sameBits(float a, float b) {
+        return std::memcmp(&a, &b, sizeof(float)) == 0;
+    }
+
+    static MeshBounds computeBounds(const std::vector<Point>& vertices) {
+        MeshBounds bounds {
+            std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(),
+            std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest()
+        };
+        for (const auto& v : vertices) {
+            bounds.minX = std::min(bounds.minX, v.x);
+            bounds.maxX = std::max(bounds.maxX, v.x);
+            bounds.minY = std::min(bounds.minY, v.y);
+            bounds.maxY = std::max(bounds.maxY, v.y);
+        }
+        if (vertices.empty()) {
+            bounds = {0, 0, 0, 0};
+        }
+        return bounds;
+    }
+
+    NameTable textures;
+    std::vector<MeshAsset> meshes;
+    // ключи дедупликации прямоугольников: размеры → id меша
+    std::vector<Point> rectangleSizes;
+    std::vector<MeshId> rectangleIds;
+};
+
+#endif // ASSETREGISTRY_H
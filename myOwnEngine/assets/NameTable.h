@@ -0,0 +1,44 @@
+#ifndef NAMETABLE_H
+#define NAMETABLE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cassert>
+
+using NameId = std::uint16_t;
+
+// Таблица интернированных строк: каждое имя хранится один раз,
+// а компоненты держат только компактный NameId
+class NameTable {
+public:
+    NameId intern(const std::string& name) {
+        auto it = ids.find(name);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        assert(names.size() < UINT16_MAX && "Name table is full.");
+        NameId id = static_cast<NameId>(names.size());
+        names.push_back(name);
+        ids.emplace(name, id);
+        return id;
+    }
+
+    bool contains(const std::string& name) const {
+        return ids.count(name) > 0;
+    }
+
+    const std::string& name(NameId id) const {
+        assert(id < names.size() && "Unknown name id.");
+        return names[id];
+    }
+
+    std::size_t size() const { return names.size(); }
+
+private:
+    std::unordered_map<std::string, NameId> ids;
+    std::vector<std::string> names;
+};
+
+#endif // NAMETABLE_H
@@ -2,6 +2,7 @@
 #define CAMERA2D_H
 
 #include "point/Point.h"
+#include "spatial/SpatialGrid.h"
 
 class Camera2D {
 public:
@@ -18,6 +19,21 @@ public:
     void setPosition(const Point& newPos) {
         position = newPos;
     }
+
+    // Кадр — квадрат со стороной 2 * halfSize вокруг position;
+    // halfSize <= 0 — без границ
+    void setViewHalfSize(float halfSize) {
+        zoom = halfSize > 0.0f ? 1.0f / halfSize : 0.0f;
+    }
+
+    // Камера видит то, что applyTransform переводит в [-1, 1] по обеим осям.
+    // zoom <= 0 — камера не настроена, видно всё.
+    bool isBounded() const { return zoom > 0.0f; }
+
+    WorldRect viewRect(float margin = 0.0f) const {
+        float half = 1.0f / zoom + margin;
+        return {position.x - half, position.y - half, position.x + half, position.y + half};
+    }
 };
 
 #endif // CAMERA2D_H
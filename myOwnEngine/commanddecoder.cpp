@@ -0,0 +1,393 @@
+#include "commanddecoder.h"
+
+namespace {
+
+// Таблицы строятся один раз; ключи — строковые литералы, живут всю программу
+const std::unordered_map<std::string_view, CommandAction>& actionTable() {
+    static const std::unordered_map<std::string_view, CommandAction> table = {
+        {"summon", CommandAction::SUMMON},
+        {"summon_wave", CommandAction::SUMMON_WAVE},
+    };
+    return table;
+}
+
+const std::unordered_map<std::string_view, Formation>& formationTable() {
+    static const std::unordered_map<std::string_view, Formation> table = {
+        {"block", Formation::BLOCK},
+        {"line", Formation::LINE},
+        {"column", Formation::COLUMN},
+        {"wedge", Formation::WEDGE},
+        {"circle", Formation::CIRCLE},
+    };
+    return table;
+}
+
+} // namespace
+
+CommandDecoder::CommandDecoder(const PrefabRegistry& prefabs)
+    : prefabs(prefabs)
+{
+}
+
+bool CommandDecoder::findAction(std::string_view name, CommandAction& out)
+{
+    const auto& table = actionTable();
+    auto it = table.find(name);
+    if (it == table.end()) return false;
+    out = it->second;
+    return true;
+}
+
+bool CommandDecoder::findFormation(std::string_view name, Formation& out)
+{
+    const auto& table = formationTable();
+    auto it = table.find(name);
+    if (it == table.end()) return false;
+    out = it->second;
+    return true;
+}
+
+bool CommandDecoder::decode(const nlohmann::json& packet, std::vector<SimCommand>& out, std::string& error) const
+{
+    auto commands = packet.find("commands");
+    if (!packet.is_object() || commands == packet.end() || !commands->is_array()) {
+        error = "expected {\"commands\":[...]}";
+        return false;
+    }
+
+    std::size_t start = out.size();
+    CommandDecoder::RawCommand raw;
+    for (const auto& cmd : *commands) {
+        if (!cmd.is_object()) {
+            error = "command must be an object";
+            out.resize(start);
+            return false;
+        }
+        raw.reset();
+        for (auto it = cmd.begin(); it != cmd.end(); ++it) {
+            const auto& value = it.value();
+            if (value.is_string()) {
+                raw.setString(it.key(), value.get_ref<const std::string&>(), prefabs);
+            } else if (value.is_number_integer()) {
+                raw.setInteger(it.key(), value.get<std::int64_t>());
+            } else if (value.is_number()) {
+                raw.setFloat(it.key(), value.get<double>());
+            } else {
+                raw.setOther(it.key());
+            }
+        }
+        if (!finishCommand(raw, out, error)) {
+            out.resize(start);
+            return false;
+        }
+    }
+    return true;
+}
+
+namespace {
+
+// SAX-обработчик для nlohmann::json::sax_parse: разбирает {"commands":[...]}
+// прямо в RawCommand по мере чтения, дерево JSON не строится
+class CommandSax {
+public:
+    CommandSax(const CommandDecoder& decoder, const PrefabRegistry& prefabs,
+               std::vector<SimCommand>& out, std::string& error)
+        : decoder(decoder), prefabs(prefabs), out(out), error(error) {}
+
+    bool sawCommands = false;
+
+    bool null() { return value([&] { raw.setOther(field); }); }
+    bool boolean(bool) { return value([&] { raw.setOther(field); }); }
+    bool number_integer(std::int64_t v) { return value([&] { raw.setInteger(field, v); }); }
+    bool number_unsigned(std::uint64_t v) {
+        return value([&] { raw.setInteger(field, v > std::uint64_t(INT64_MAX) ? INT64_MAX : std::int64_t(v)); });
+    }
+    bool number_float(double v, const std::string&) { return value([&] { raw.setFloat(field, v); }); }
+    bool string(std::string& v) { return value([&] { raw.setString(field, v, prefabs); }); }
+    bool binary(nlohmann::json::binary_t&) { return value([&] { raw.setOther(field); }); }
+
+    bool start_object(std::size_t) {
+        if (depth == 0) {
+            ++depth;
+            return true;
+        }
+        if (depth == 2 && inCommands) {
+            raw.reset();
+            ++depth;
+            return true;
+        }
+        return nested();
+    }
+
+    bool end_object() {
+        if (skipDepth > 0) {
+            --skipDepth;
+            return true;
+        }
+        --depth;
+        if (depth == 2 && inCommands) {
+            return decoder.finishCommand(raw, out, error);
+        }
+        if (depth == 0 && !sawCommands) {
+            return fail("expected {\"commands\":[...]}");
+        }
+        return true;
+    }
+
+    bool start_array(std::size_t) {
+        if (depth == 1 && rootKey == "commands") {
+            inCommands = true;
+            sawCommands = true;
+            ++depth;
+            return true;
+        }
+        if (depth == 0) {
+            return fail("expected {\"commands\":[...]}");
+        }
+        return nested();
+    }
+
+    bool end_array() {
+        if (skipDepth > 0) {
+            --skipDepth;
+            return true;
+        }
+        --depth;
+        inCommands = false;
+        return true;
+    }
+
+    bool key(std::string& k) {
+        if (skipDepth > 0) return true;
+        if (depth == 1) {
+            rootKey.assign(k); // ёмкость переиспользуется между пакетами
+        } else if (depth == 3) {
+            field.assign(k);
+        }
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::json::exception& e) {
+        error = e.what();
+        return false;
+    }
+
+private:
+    // скаляр в текущей позиции
+    template<typename Assign>
+    bool value(Assign assign) {
+        if (skipDepth > 0) return true;
+        if (depth == 3) {
+            assign();
+            return true;
+        }
+        if (depth == 2 && inCommands) return fail("command must be an object");
+        if (depth == 1 && rootKey == "commands") return fail("expected {\"commands\":[...]}");
+        if (depth == 0) return fail("expected {\"commands\":[...]}");
+        return true;
+    }
+
+    // вложенный объект/массив, который нас не интересует, пропускается целиком
+    bool nested() {
+        if (skipDepth == 0) {
+            if (depth == 3) raw.setOther(field);
+            if (depth == 2 && inCommands) return fail("command must be an object");
+            if (depth == 1 && rootKey == "commands") return fail("expected {\"commands\":[...]}");
+        }
+        ++skipDepth;
+        return true;
+    }
+
+    bool fail(const char* message) {
+        error = message;
+        return false;
+    }
+
+    const CommandDecoder& decoder;
+    const PrefabRegistry& prefabs;
+    std::vector<SimCommand>& out;
+    std::string& error;
+
+    CommandDecoder::RawCommand raw;
+    std::string rootKey;
+    std::string field;
+    int depth = 0;
+    int skipDepth = 0;
+    bool inCommands = false;
+};
+
+} // namespace
+
+bool CommandDecoder::decode(const char* data, std::size_t size, std::vector<SimCommand>& out, std::string& error) const
+{
+    std::size_t start = out.size();
+    CommandSax sax(*this, prefabs, out, error);
+    bool ok = nlohmann::json::sax_parse(data, data + size, &sax);
+    if (ok && !sax.sawCommands) {
+        error = "expected {\"commands\":[...]}";
+        ok = false;
+    }
+    if (!ok) {
+        out.resize(start);
+    }
+    return ok;
+}
+
+bool CommandDecoder::finishCommand(const RawCommand& raw, std::vector<SimCommand>& out, std::string& error) const
+{
+    if (!raw.hasAction) {
+        error = "command without \"action\"";
+        return false;
+    }
+    if (!raw.actionKnown) {
+        return true; // новые действия старым сервером игнорируются
+    }
+    if (!raw.hasUnit || !raw.hasX || !raw.hasY) {
+        error = "summon needs \"unit\", \"x\", \"y\"";
+        return false;
+    }
+    if (raw.unit == INVALID_PREFAB) {
+        error = "unknown unit: " + raw.unitName;
+        return false;
+    }
+    if (raw.hasCount && !raw.countIsInteger) {
+        error = "\"count\" must be an integer";
+        return false;
+    }
+    if (raw.count < 1 || raw.count > MAX_COUNT) {
+        error = "\"count\" out of range";
+        return false;
+    }
+
+    SimCommand command;
+    command.action = raw.action;
+    command.unit = raw.unit;
+    command.x = raw.x;
+    command.y = raw.y;
+    command.count = static_cast<std::uint16_t>(raw.count);
+    command.formation = Formation::BLOCK;
+    command.spacing = 0.0f;
+
+    if (raw.action == CommandAction::SUMMON_WAVE) {
+        if (raw.hasFormation && !raw.formationKnown) {
+            error = "unknown formation";
+            return false;
+        }
+        if (raw.hasSpacing && !raw.spacingIsNumber) {
+            error = "\"spacing\" must be a number";
+            return false;
+        }
+        command.formation = raw.formation;
+        command.spacing = raw.spacing;
+    }
+    out.push_back(command);
+    return true;
+}
+
+binproto::Status CommandDecoder::decode(const binproto::CommandRecord& record, SimCommand& out) const
+{
+    switch (record.op) {
+    case binproto::Op::SUMMON:
+        out.action = CommandAction::SUMMON;
+        break;
+    case binproto::Op::SUMMON_WAVE:
+        out.action = CommandAction::SUMMON_WAVE;
+        break;
+    case binproto::Op::MOVE:
+    case binproto::Op::ABILITY:
+        return binproto::Status::UNSUPPORTED; // в симуляции пока нет таких команд
+    default:
+        return binproto::Status::BAD_RECORD;
+    }
+
+    if (record.unit >= std::uint8_t(binproto::UnitType::COUNT) ||
+        record.count < 1 || record.count > MAX_COUNT ||
+        record.formation > std::uint8_t(Formation::CIRCLE)) {
+        return binproto::Status::BAD_RECORD;
+    }
+    out.unit = prefabs.find(binproto::UNIT_NAMES[record.unit]);
+    if (out.unit == INVALID_PREFAB) {
+        return binproto::Status::BAD_RECORD;
+    }
+
+    out.x = binproto::dequantize(record.x);
+    out.y = binproto::dequantize(record.y);
+    out.count = record.count;
+    out.formation = Formation::BLOCK;
+    out.spacing = 0.0f;
+    if (out.action == CommandAction::SUMMON_WAVE) {
+        out.formation = Formation(record.formation);
+        out.spacing = record.param / binproto::QUANT_SCALE;
+    }
+    return binproto::Status::OK;
+}
+
+void CommandDecoder::RawCommand::reset()
+{
+    hasAction = actionKnown = false;
+    hasUnit = hasX = hasY = false;
+    x = y = 0.0f;
+    unit = INVALID_PREFAB;
+    hasCount = countIsInteger = false;
+    count = 1;
+    hasFormation = formationKnown = false;
+    formation = Formation::BLOCK;
+    hasSpacing = spacingIsNumber = false;
+    spacing = 0.0f;
+    unitName.clear();
+}
+
+void CommandDecoder::RawCommand::setString(const std::string& key, const std::string& value, const PrefabRegistry& prefabs)
+{
+    if (key == "action") {
+        hasAction = true;
+        actionKnown = findAction(value, action);
+    } else if (key == "unit") {
+        hasUnit = true;
+        unit = prefabs.find(value);
+        if (unit == INVALID_PREFAB) unitName.assign(value); // только для текста ошибки
+    } else if (key == "formation") {
+        hasFormation = true;
+        formationKnown = findFormation(value, formation);
+    } else {
+        setOther(key);
+    }
+}
+
+void CommandDecoder::RawCommand::setInteger(const std::string& key, std::int64_t value)
+{
+    if (key == "count") {
+        hasCount = countIsInteger = true;
+        count = value;
+    } else {
+        setFloat(key, double(value));
+    }
+}
+
+void CommandDecoder::RawCommand::setFloat(const std::string& key, double value)
+{
+    if (key == "x") {
+        hasX = true;
+        x = float(value);
+    } else if (key == "y") {
+        hasY = true;
+        y = float(value);
+    } else if (key == "spacing") {
+        hasSpacing = spacingIsNumber = true;
+        spacing = float(value);
+    } else {
+        setOther(key);
+    }
+}
+
+void CommandDecoder::RawCommand::setOther(const std::string& key)
+{
+    // поле есть, но тип не тот — при проверке это будет ошибкой
+    if (key == "action") { hasAction = false; }
+    else if (key == "unit") { hasUnit = false; }
+    else if (key == "x") { hasX = false; }
+    else if (key == "y") { hasY = false; }
+    else if (key == "count") { hasCount = true; countIsInteger = false; }
+    else if (key == "formation") { hasFormation = true; formationKnown = false; }
+    else if (key == "spacing") { hasSpacing = true; spacingIsNumber = false; }
+}
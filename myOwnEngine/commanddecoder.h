@@ -0,0 +1,69 @@
+#ifndef COMMANDDECODER_H
+#define COMMANDDECODER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "simcommand.h"
+#include "protocol/BinaryProtocol.h"
+#include "prefabs/PrefabRegistry.h"
+#include "json.hpp"
+
+// Проверяет пакет {"commands":[...]} один раз и переводит его в SimCommand:
+// действия и построения ищутся в общих таблицах string_view → enum,
+// юниты — в реестре префабов, без копирования строк из JSON
+class CommandDecoder {
+public:
+    explicit CommandDecoder(const PrefabRegistry& prefabs);
+
+    // Дописывает команды в out. При ошибке возвращает false, out не меняется,
+    // причина — в error. Неизвестные действия пропускаются.
+    bool decode(const nlohmann::json& packet, std::vector<SimCommand>& out, std::string& error) const;
+
+    // То же прямо из сырого буфера пакета через SAX-интерфейс nlohmann:
+    // без копии в std::string и без построения DOM
+    bool decode(const char* data, std::size_t size, std::vector<SimCommand>& out, std::string& error) const;
+
+    // Одна запись бинарного протокола. GET_STATE не является командой
+    // симуляции и обрабатывается сервером отдельно.
+    binproto::Status decode(const binproto::CommandRecord& record, SimCommand& out) const;
+
+    static bool findAction(std::string_view name, CommandAction& out);
+    static bool findFormation(std::string_view name, Formation& out);
+    PrefabId findUnit(const std::string& name) const { return prefabs.find(name); }
+
+    static constexpr int MAX_COUNT = MAX_ENTITIES;
+
+    // Поля одной команды по мере чтения (в любом порядке ключей)
+    struct RawCommand {
+        bool hasAction, actionKnown;
+        CommandAction action;
+        bool hasUnit;
+        PrefabId unit;
+        std::string unitName; // только если юнит не найден
+        bool hasX, hasY;
+        float x, y;
+        bool hasCount, countIsInteger;
+        std::int64_t count;
+        bool hasFormation, formationKnown;
+        Formation formation;
+        bool hasSpacing, spacingIsNumber;
+        float spacing;
+
+        RawCommand() { reset(); }
+        void reset();
+        void setString(const std::string& key, const std::string& value, const PrefabRegistry& prefabs);
+        void setInteger(const std::string& key, std::int64_t value);
+        void setFloat(const std::string& key, double value);
+        void setOther(const std::string& key);
+    };
+
+    // Проверяет собранную команду и дописывает её в out (если действие известно)
+    bool finishCommand(const RawCommand& raw, std::vector<SimCommand>& out, std::string& error) const;
+
+private:
+    const PrefabRegistry& prefabs;
+};
+
+#endif // COMMANDDECODER_H
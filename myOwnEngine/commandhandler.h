@@ -3,63 +3,57 @@
 
 #include "scene/scene.h"
 #include "json.hpp"
+#include "commanddecoder.h"
+#include <stdexcept>
 #include <string>
-#include "entitybuilder.h"
+#include <vector>
 
 class CommandHandler {
 public:
+    // Бросает std::invalid_argument, если пакет не прошёл проверку;
+    // тогда ни одна команда из пакета не применяется
     void handle(const nlohmann::json& commands, Scene& scene) {
-        for (const auto& cmd : commands["commands"]) {
-            std::string action = cmd["action"];
-            if (action == "summon") {
-                std::string unit = cmd["unit"];
-                float x = cmd["x"];
-                float y = cmd["y"];
-                if (unit == "soldier") {
-                    EntityBuilder(scene)
-                    .withTransform({x, y})
-                        .withVelocity()
-                        .withHealth(100)
-                        .withTeam(TeamComponent::ALLY)
-                        .withMesh("ally.png", 1.3f, 1.3f)
-                        .withAI()
-                        .withCombat(0.5f, 10)
-                        .withCollidable()
-                        .build();
-                } else if (unit == "enemy") {
-                    EntityBuilder(scene)
-                    .withTransform({x, y})
-                        .withVelocity()
-                        .withHealth(100)
-                        .withTeam(TeamComponent::ENEMY)
-                        .withMesh("enemy.png", 1.3f, 1.3f)
-                        .withAI()
-                        .withCombat(0.5f, 10)
-                        .withCollidable()
-                        .build();
-                } else if (unit == "fort") {
-                    EntityBuilder(scene)
-                    .withTransform({x, y})
-                        .withHealth(300)
-                        .withTeam(TeamComponent::ALLY)
-                        .withMesh("fort.png", 2.0f, 2.4f)
-                        .withCollidable()
-                        .build();
-                } else if (unit == "archer") {
-                    EntityBuilder(scene)
-                    .withTransform({x, y})
-                        .withVelocity()
-                        .withHealth(80)
-                        .withTeam(TeamComponent::ALLY)
-                        .withMesh("archer.png", 1.3f, 1.3f)
-                        .withAI()
-                        .withCombat(2.5f, 6)   // Дальше радиус, меньше урон
-                        .withCollidable()
-                        .build();
-                }
-            }
+        CommandDecoder decoder(scene.getPrefabs());
+        std::string error;
+        decoded.clear();
+        if (!decoder.decode(commands, decoded, error)) {
+            throw std::invalid_argument(error);
         }
+        apply(decoded, scene);
     }
+
+    // Пакет прямо из сетевого буфера, без DOM
+    void handle(const char* data, std::size_t size, Scene& scene) {
+        CommandDecoder decoder(scene.getPrefabs());
+        std::string error;
+        decoded.clear();
+        if (!decoder.decode(data, size, decoded, error)) {
+            throw std::invalid_argument(error);
+        }
+        apply(decoded, scene);
+    }
+
+    std::size_t lastCommandCount() const { return decoded.size(); }
+
+    void apply(const std::vector<SimCommand>& commands, Scene& scene) {
+        for (const auto& cmd : commands) {
+            apply(cmd, scene);
+        }
+    }
+
+    void apply(const SimCommand& cmd, Scene& scene) {
+        switch (cmd.action) {
+        case CommandAction::SUMMON:
+            scene.spawn(cmd.unit, {cmd.x, cmd.y}, cmd.count);
+            break;
+        case CommandAction::SUMMON_WAVE:
+            scene.spawnBatch(cmd.unit, {cmd.x, cmd.y}, cmd.count, cmd.formation, cmd.spacing);
+            break;
+        }
+    }
+
+private:
+    std::vector<SimCommand> decoded; // переиспользуется между пакетами
 };
 
 
@@ -5,6 +5,9 @@
 #include <typeindex>
 #include <memory>
 #include <cassert>
+#include <vector>
+#include <memory_resource>
+#include <cstdint>
 #include "entity/Entity.h"
 
 class IComponentArray {
@@ -16,55 +19,101 @@ public:
     virtual void* getDataPtr(Entity entity) = 0;
 };
 
+// Компоненты одного типа лежат подряд в плотном массиве (sparse set):
+// sparse[entity] — индекс в dense, удаление переносит последний элемент.
+// Ёмкость резервируется на MAX_ENTITIES, поэтому вставка не двигает
+// уже выданные ссылки; удаление двигает только последний элемент.
 template<typename T>
 class ComponentArray : public IComponentArray {
 private:
-    std::unordered_map<Entity, T> componentMap;
+    static constexpr std::uint32_t NOT_FOUND = UINT32_MAX;
+
+    std::vector<T> dense;
+    std::vector<Entity> denseEntities;
+    std::vector<std::uint32_t> sparse;
 
 public:
+    ComponentArray() : sparse(MAX_ENTITIES, NOT_FOUND) {
+        dense.reserve(MAX_ENTITIES);
+        denseEntities.reserve(MAX_ENTITIES);
+    }
+
     // Основной виртуальный метод (без параметра компонента)
     void insertData(Entity entity) override {
-        componentMap[entity] = T{};  // Создаем компонент по умолчанию
+        insertData(entity, T{});  // Создаем компонент по умолчанию
     }
 
     // Дополнительный метод (не виртуальный) с параметром компонента
     void insertData(Entity entity, T component) {
-        componentMap[entity] = component;
+        assert(entity < MAX_ENTITIES && "Entity out of range.");
+        if (hasData(entity)) {
+            dense[sparse[entity]] = std::move(component);
+            return;
+        }
+        sparse[entity] = static_cast<std::uint32_t>(dense.size());
+        dense.push_back(std::move(component));
+        denseEntities.push_back(entity);
+    }
+
+    // Одно и то же значение для пачки новых сущностей, записывается подряд
+    void insertBatch(const Entity* entities, std::size_t count, const T& component) {
+        for (std::size_t i = 0; i < count; ++i) {
+            insertData(entities[i], component);
+        }
     }
 
     void removeEntity(Entity entity) override {
-        componentMap.erase(entity);
+        if (!hasData(entity)) return;
+        std::uint32_t index = sparse[entity];
+        std::uint32_t lastIndex = static_cast<std::uint32_t>(dense.size() - 1);
+        if (index != lastIndex) {
+            dense[index] = std::move(dense[lastIndex]);
+            denseEntities[index] = denseEntities[lastIndex];
+            sparse[denseEntities[index]] = index;
+        }
+        dense.pop_back();
+        denseEntities.pop_back();
+        sparse[entity] = NOT_FOUND;
     }
 
     bool hasData(Entity entity) const override {
-        return componentMap.count(entity) > 0;
+        return entity < sparse.size() && sparse[entity] != NOT_FOUND;
     }
 
     void* getDataPtr(Entity entity) override {
-        return &componentMap.at(entity);
+        assert(hasData(entity) && "Component not found for entity.");
+        return &dense[sparse[entity]];
     }
 
     T& getData(Entity entity) {
         assert(hasData(entity) && "Component not found for entity.");
-        return componentMap[entity];
+        return dense[sparse[entity]];
     }
 
     const T& getData(Entity entity) const {
         assert(hasData(entity) && "Component not found for entity.");
-        return componentMap.at(entity);
+        return dense[sparse[entity]];
     }
-    std::vector<Entity> getAllEntities() const {
-        std::vector<Entity> entities;
-        for (const auto& pair : componentMap) {
-            entities.push_back(pair.first);
+
+    std::size_t size() const { return dense.size(); }
+
+    std::pmr::vector<Entity> getAllEntities(std::pmr::memory_resource* resource) const {
+        return std::pmr::vector<Entity>(denseEntities.begin(), denseEntities.end(), resource);
+    }
+
+    template<typename Func>
+    void forEach(Func&& func) const {
+        for (std::size_t i = 0; i < dense.size(); ++i) {
+            func(denseEntities[i], dense[i]);
         }
-        return entities;
     }
 };
 
 class ComponentManager {
 private:
     std::unordered_map<std::type_index, std::shared_ptr<IComponentArray>> componentArrays;
+    // откуда берутся временные списки (арена тика у Scene)
+    std::pmr::memory_resource* transientResource = std::pmr::get_default_resource();
 
     template<typename T>
     std::shared_ptr<ComponentArray<T>> getComponentArray() {
@@ -87,15 +136,25 @@ private:
     }
 
 
+    // Без копирования shared_ptr (и атомарного счётчика) на каждый доступ
+    template<typename T>
+    ComponentArray<T>& getArray() {
+        auto it = componentArrays.find(std::type_index(typeid(T)));
+        if (it != componentArrays.end()) {
+            return static_cast<ComponentArray<T>&>(*it->second);
+        }
+        return *getComponentArray<T>();
+    }
+
 public:
     template<typename T>
     void addComponent(Entity entity, T component) {
-        getComponentArray<T>()->insertData(entity, component);
+        getArray<T>().insertData(entity, std::move(component));
     }
 
     template<typename T>
     void addComponent(Entity entity) {
-        getComponentArray<T>()->insertData(entity);
+        getArray<T>().insertData(entity);
     }
 
     template<typename T>
@@ -107,13 +166,19 @@ public:
 
     template<typename T>
     T& getComponent(Entity entity) {
-        return getComponentArray<T>()->getData(entity);
+        return getArray<T>().getData(entity);
     }
 
     template<typename T>
     const T& getComponent(Entity entity) const {
         return getComponentArray<T>()->getData(entity);
     }
+
+    // Пачка новых сущностей с одинаковым компонентом
+    template<typename T>
+    void addComponents(const Entity* entities, std::size_t count, const T& component) {
+        getArray<T>().insertBatch(entities, count, component);
+    }
     template<typename T>
     std::type_index getComponentType() const {
         return std::type_index(typeid(T));
@@ -138,15 +203,29 @@ public:
             componentArray->removeEntity(entity);
         }
     }
+    void setTransientResource(std::pmr::memory_resource* resource) {
+        transientResource = resource;
+    }
+
+    // Временный список: живёт не дольше текущего тика
     template<typename T>
-    std::vector<Entity> getAllEntitiesWith() const {
+    std::pmr::vector<Entity> getAllEntitiesWith() const {
         std::type_index typeName(typeid(T));
         auto it = componentArrays.find(typeName);
         if (it != componentArrays.end()) {
             auto componentArray = std::static_pointer_cast<ComponentArray<T>>(it->second);
-            return componentArray->getAllEntities();
+            return componentArray->getAllEntities(transientResource);
+        }
+        return std::pmr::vector<Entity>(transientResource);
+    }
+
+    // Обход без промежуточного списка: func(Entity, const T&)
+    template<typename T, typename Func>
+    void forEachEntityWith(Func&& func) const {
+        auto it = componentArrays.find(std::type_index(typeid(T)));
+        if (it != componentArrays.end()) {
+            static_cast<const ComponentArray<T>&>(*it->second).forEach(std::forward<Func>(func));
         }
-        return {};
     }
 };
 
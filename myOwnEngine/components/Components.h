@@ -3,9 +3,12 @@
 
 #include "point/Point.h"
 #include <vector>
+#include <cstdint>
 #include "components/ComponentManager.h"
 #include <string>
-#include <unordered_map>
+#include <functional>
+#include "components/ResourceMap.h"
+#include "assets/AssetRegistry.h"
 
 
 struct TransformComponent {
@@ -36,14 +39,13 @@ struct VelocityComponent {
     VelocityComponent(float x, float y) : velocity{x, y} {}
 };
 
+// Геометрия и имя текстуры лежат в AssetRegistry сцены,
+// у сущности только два компактных id
 struct MeshComponent {
-    std::vector<Point> vertices;
-    std::string textureName;
-    float width = 0.5f;
-    float height = 0.5f;
+    MeshId mesh = 0;
+    TextureId texture = 0;
     MeshComponent() = default;
-    MeshComponent(std::vector<Point> verts, std::string txtrName)
-        : vertices(std::move(verts)), textureName(txtrName) {}
+    MeshComponent(MeshId m, TextureId txtr) : mesh(m), texture(txtr) {}
 };
 
 struct CollidableComponent {
@@ -76,6 +78,23 @@ struct CombatComponent {
 
 struct AIComponent {
     enum State { MOVING, ATTACKING, RELOADING  } state = MOVING;
+    // искать цель на ближайшем тике, не дожидаясь своей очереди
+    // (новый юнит или прежняя цель погибла)
+    bool needsRetarget = true;
+    // прямой путь к цели перекрыт стеной — идти по полю направлений;
+    // проверяется при выборе цели
+    bool followFlowField = false;
+};
+
+// Собственный маршрут в обход статичных препятствий (HPA*) — для юнитов,
+// которым мало общего поля направлений. AISystem задаёт goal,
+// PathfindingSystem ищет путь в фоне и записывает точки поворота.
+struct PathComponent {
+    Point goal;
+    bool replan = false;          // goal сменился — нужен новый поиск
+    std::uint32_t requestId = 0;  // ждём ответ на этот запрос; 0 — не ждём
+    std::vector<Point> waypoints; // пусто — пути нет (ещё не найден или не существует)
+    std::size_t next = 0;         // индекс текущей точки в waypoints
 };
 
 
@@ -86,11 +105,11 @@ struct WinConditionComponent {
 
 
 struct ResourceComponent {
-    std::unordered_map<std::string, float> resources;
+    ResourceMap resources;
 };
 
 struct UnitCostComponent {
-    std::unordered_map<std::string, float> cost;
+    ResourceMap cost;
 };
 
 
@@ -0,0 +1,69 @@
+#ifndef RESOURCEMAP_H
+#define RESOURCEMAP_H
+
+#include <array>
+#include <string>
+#include <cstdint>
+#include <stdexcept>
+#include "assets/NameTable.h"
+
+using ResourceId = NameId;
+
+// Имена ресурсов ("elixir", "gold", ...) общие для всех сцен
+inline NameTable& resourceNames() {
+    static NameTable table;
+    return table;
+}
+
+inline ResourceId resourceId(const std::string& name) {
+    return resourceNames().intern(name);
+}
+
+// Карта ресурсов фиксированной ёмкости, целиком внутри компонента:
+// у юнита всего несколько видов ресурсов, куча для них не нужна
+class ResourceMap {
+public:
+    static constexpr std::size_t CAPACITY = 4;
+
+    struct Entry {
+        ResourceId id;
+        float amount;
+    };
+
+    // Как у unordered_map: отсутствующий ресурс заводится с нулём.
+    // Места под новый нет — исключение, а не запись за край массива.
+    float& operator[](ResourceId id) {
+        for (std::uint8_t i = 0; i < count; ++i) {
+            if (entries[i].id == id) return entries[i].amount;
+        }
+        if (count == CAPACITY) {
+            throw std::length_error("ResourceMap capacity exceeded: " + resourceNames().name(id));
+        }
+        entries[count] = {id, 0.0f};
+        return entries[count++].amount;
+    }
+
+    float get(ResourceId id) const {
+        for (std::uint8_t i = 0; i < count; ++i) {
+            if (entries[i].id == id) return entries[i].amount;
+        }
+        return 0.0f;
+    }
+
+    bool contains(ResourceId id) const {
+        for (std::uint8_t i = 0; i < count; ++i) {
+            if (entries[i].id == id) return true;
+        }
+        return false;
+    }
+
+    std::size_t size() const { return count; }
+    const Entry* begin() const { return entries.data(); }
+    const Entry* end() const { return entries.data() + count; }
+
+private:
+    std::array<Entry, CAPACITY> entries{};
+    std::uint8_t count = 0;
+};
+
+#endif // RESOURCEMAP_H
@@ -0,0 +1,62 @@
+#ifndef ACTIVITYSET_H
+#define ACTIVITYSET_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "Entity.h"
+#include "EntitySet.h"
+
+// Бодрствующие сущности. Кто SLEEP_TICKS тиков подряд простоял, засыпает
+// и выпадает из обхода MovementSystem и CollisionSystem — в осаде, где
+// почти все стоят и бьют, за тик обходятся только идущие. Разбудить —
+// wake(): так делает всё, что меняет скорость, положение или состав
+// компонентов. Новые сущности бодрствуют.
+class ActivitySet {
+public:
+    static constexpr std::uint32_t SLEEP_TICKS = 8;
+
+    ActivitySet() : stillTicks(MAX_ENTITIES, 0) {}
+
+    void wake(Entity entity) {
+        if (entity >= MAX_ENTITIES) return;
+        stillTicks[entity] = 0;
+        awake.insert(entity);
+    }
+    void wake(const Entity* entities, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            wake(entities[i]);
+        }
+    }
+    // Удалённая сущность; её id может достаться новой
+    void remove(Entity entity) {
+        if (entity >= MAX_ENTITIES) return;
+        stillTicks[entity] = 0;
+        awake.erase(entity);
+    }
+
+    // Сущность простояла весь тик. Засыпает она в flush(), а не сразу:
+    // getAwake() в это время может обходиться.
+    void markStill(Entity entity) {
+        if (++stillTicks[entity] == SLEEP_TICKS) fallingAsleep.push_back(entity);
+    }
+    void markMoving(Entity entity) { stillTicks[entity] = 0; }
+
+    // Конец тика: усыпляет простоявших, если их с тех пор не разбудили
+    void flush() {
+        for (Entity entity : fallingAsleep) {
+            if (stillTicks[entity] >= SLEEP_TICKS) awake.erase(entity);
+        }
+        fallingAsleep.clear();
+    }
+
+    bool isAwake(Entity entity) const { return awake.count(entity) != 0; }
+    const EntitySet& getAwake() const { return awake; }
+
+private:
+    EntitySet awake;
+    std::vector<std::uint32_t> stillTicks; // индекс — Entity
+    std::vector<Entity> fallingAsleep;
+};
+
+#endif // ACTIVITYSET_H
@@ -28,12 +28,30 @@ public:
         return id;
     }
 
+    // Резервирует сразу count id (вызывающий проверяет getAvailableCount)
+    void createEntities(std::size_t count, Entity* out) {
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] = availableEntities.front();
+            availableEntities.pop();
+            aliveEntities.insert(aliveEntities.end(), out[i]);
+        }
+        livingEntityCount += static_cast<Entity>(count);
+    }
+
     void destroyEntity(Entity entity) {
         aliveEntities.erase(entity);
         availableEntities.push(entity);
         --livingEntityCount;
     }
 
+    std::size_t getAvailableCount() const {
+        return availableEntities.size();
+    }
+
+    bool isAlive(Entity entity) const {
+        return aliveEntities.count(entity) > 0;
+    }
+
     const std::set<Entity>& getAliveEntities() const {
         return aliveEntities;
     }
@@ -0,0 +1,61 @@
+#ifndef ENTITYSET_H
+#define ENTITYSET_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "Entity.h"
+
+// Множество сущностей в виде sparse set: плотный массив для обхода
+// и индекс по id для O(1) вставки/удаления/поиска.
+// Удаление переносит последний элемент на место удалённого,
+// поэтому порядок обхода — порядок вставки с поправкой на удаления.
+class EntitySet {
+public:
+    EntitySet() : sparse(MAX_ENTITIES, NOT_FOUND) {}
+
+    bool insert(Entity entity) {
+        if (count(entity)) return false;
+        sparse[entity] = static_cast<std::uint32_t>(dense.size());
+        dense.push_back(entity);
+        return true;
+    }
+
+    // Добавление пачки за один проход (повторы пропускаются)
+    void append(const Entity* entities, std::size_t n) {
+        dense.reserve(dense.size() + n);
+        for (std::size_t i = 0; i < n; ++i) {
+            insert(entities[i]);
+        }
+    }
+
+    bool erase(Entity entity) {
+        if (!count(entity)) return false;
+        std::uint32_t index = sparse[entity];
+        Entity last = dense.back();
+        dense[index] = last;
+        sparse[last] = index;
+        dense.pop_back();
+        sparse[entity] = NOT_FOUND;
+        return true;
+    }
+
+    std::size_t count(Entity entity) const {
+        return entity < sparse.size() && sparse[entity] != NOT_FOUND ? 1 : 0;
+    }
+
+    std::size_t size() const { return dense.size(); }
+    bool empty() const { return dense.empty(); }
+    const Entity* data() const { return dense.data(); }
+
+    std::vector<Entity>::const_iterator begin() const { return dense.begin(); }
+    std::vector<Entity>::const_iterator end() const { return dense.end(); }
+
+private:
+    static constexpr std::uint32_t NOT_FOUND = UINT32_MAX;
+
+    std::vector<Entity> dense;
+    std::vector<std::uint32_t> sparse;
+};
+
+#endif // ENTITYSET_H
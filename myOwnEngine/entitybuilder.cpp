@@ -28,11 +28,10 @@ EntityBuilder& EntityBuilder::withTeam(TeamComponent::Team team) {
 }
 
 EntityBuilder& EntityBuilder::withMesh(const std::string& textureName, float w, float h) {
+    auto& assets = scene.getAssets();
     MeshComponent mesh;
-    mesh.textureName = textureName; // просто имя файла!
-    mesh.width = w;
-    mesh.height = h;
-    mesh.vertices = makeRectangleMesh(w, h);
+    mesh.texture = assets.internTexture(textureName); // просто имя файла!
+    mesh.mesh = assets.internRectangle(w, h);         // один квад на всех одинаковых юнитов
     scene.addComponent<MeshComponent>(entity, mesh);
     return *this;
 }
@@ -5,7 +5,9 @@
 #include <QFont>
 #include <QColor>
 #include <QPainter>
+#include <QStaticText>
 #include <vector>
+#include <cstddef>
 
 
 struct UILabel {
@@ -13,29 +15,70 @@ struct UILabel {
     QPointF position; // 0.0 - 1.0 нормализованные координаты относительно окна
     QFont font;
     QColor color;
+    QStaticText layout; // раскладка текста, пересчитывается только при смене text
+    std::size_t group;  // индекс группы шрифт+цвет в UILabelManager
 };
 
 class UILabelManager {
 public:
-    void addLabel(const QString& text, const QPointF& pos, const QFont& font = QFont(), const QColor& color = Qt::white) {
-        labels.push_back({text, pos, font, color});
+    // Возвращает номер подписи для setText
+    std::size_t addLabel(const QString& text, const QPointF& pos, const QFont& font = QFont(), const QColor& color = Qt::white) {
+        std::size_t group = groupFor(font, color);
+        QStaticText layout(text);
+        layout.setPerformanceHint(QStaticText::AggressiveCaching);
+        labels.push_back({text, pos, font, color, layout, group});
+        groups[group].labels.push_back(labels.size() - 1);
+        return labels.size() - 1;
+    }
+
+    // Меняет текст; раскладка пересобирается, только если он другой
+    void setText(std::size_t label, const QString& text) {
+        UILabel& l = labels[label];
+        if (l.text == text) return;
+        l.text = text;
+        l.layout.setText(text);
     }
 
     void clear() {
         labels.clear();
+        groups.clear();
     }
 
+    // Подписи идут группами: шрифт и перо ставятся один раз на группу,
+    // а не на каждую подпись. position — точка на базовой линии, как у
+    // drawText; drawStaticText же ставит в точку левый верхний угол,
+    // поэтому поднимаем на ascent.
     void render(QPainter& painter, const QSize& windowSize) {
-        for (const auto& label : labels) {
-            painter.setPen(label.color);
-            painter.setFont(label.font);
-            QPoint pixelPos(label.position.x() * windowSize.width(), label.position.y() * windowSize.height());
-            painter.drawText(pixelPos, label.text);
+        for (const auto& group : groups) {
+            painter.setPen(group.color);
+            painter.setFont(group.font);
+            const qreal ascent = painter.fontMetrics().ascent();
+            for (std::size_t index : group.labels) {
+                const auto& label = labels[index];
+                QPointF pixelPos(label.position.x() * windowSize.width(),
+                                 label.position.y() * windowSize.height() - ascent);
+                painter.drawStaticText(pixelPos, label.layout);
+            }
         }
     }
 
 private:
+    struct LabelGroup {
+        QFont font;
+        QColor color;
+        std::vector<std::size_t> labels;
+    };
+
+    std::size_t groupFor(const QFont& font, const QColor& color) {
+        for (std::size_t i = 0; i < groups.size(); ++i) {
+            if (groups[i].font == font && groups[i].color == color) return i;
+        }
+        groups.push_back({font, color, {}});
+        return groups.size() - 1;
+    }
+
     std::vector<UILabel> labels;
+    std::vector<LabelGroup> groups;
 };
 
 #endif // LABELS_H
@@ -3,60 +3,279 @@
 #include <QTcpSocket>
 #include <QDebug>
 #include <QTimer>
+#include <QFile>
+#include <QCommandLineParser>
+#include <memory>
+#include <memory_resource>
+#include <algorithm>
 #include "scene/scene.h"
 #include "CommandHandler.h"
+#include "stateserializer.h"
+#include "protocol/BinaryProtocol.h"
 #include "json.hpp"
 
 using json = nlohmann::json;
 
-json serializeScene(const Scene& scene) {
-    json state;
-    state["entities"] = json::array();
-    for (const auto& entity : scene.getAllEntities()) {
-        if (!scene.hasComponent<TransformComponent>(entity)) continue;
-        const auto& transform = scene.getComponent<TransformComponent>(entity);
-
-        // Могут быть дефолтные значения
-        std::string type = "soldier"; // Можешь расширить если есть другие типы
-        std::string texture = "default.png";
-        float width = 0.5f;
-        float height = 0.5f;
-
-        if (scene.hasComponent<MeshComponent>(entity)) {
-            const auto& mesh = scene.getComponent<MeshComponent>(entity);
-            texture = mesh.textureName;
-            width = mesh.width;
-            height = mesh.height;
+// Состояние соединения: протокол определяется по первым байтам
+struct ClientSession {
+    enum Protocol { UNKNOWN, JSON, BINARY } protocol = UNKNOWN;
+    QByteArray buffer; // недочитанные байты (HELLO или бинарные записи)
+    QByteArray reply;  // переиспользуемый буфер ответа
+    // Переиспользуемый буфер сериализации состояния. Не арена тика: клиент
+    // может прислать сколько угодно get_state за тик, и арена, растущая
+    // под пик, раздулась бы навсегда. Здесь же держится не больше одного
+    // состояния, и память уходит вместе с сессией.
+    std::pmr::string state;
+    std::unique_ptr<StateDeltaTracker> stream; // есть, если клиент подписан на дельты
+};
+
+struct Subscriber {
+    QTcpSocket* client;
+    std::shared_ptr<ClientSession> session;
+};
+
+// Дельты рассылаются раз в STREAM_INTERVAL_TICKS тиков (16 мс каждый, ~10 Гц);
+// между ними клиент интерполирует положения сам
+const int STREAM_INTERVAL_TICKS = 6;
+// Если клиент не успевает забирать данные, дельта пропускается: изменения
+// копятся в трекере и уйдут одним сообщением, когда сокет разгрузится
+const qint64 STREAM_BACKLOG_LIMIT = 1 << 20;
+
+static void pushDelta(const Subscriber& subscriber, Scene& scene)
+{
+    if (subscriber.client->bytesToWrite() > STREAM_BACKLOG_LIMIT) return;
+    std::pmr::string& delta = subscriber.session->state;
+    subscriber.session->stream->serializeDelta(scene, delta);
+    if (delta.empty()) return;
+    delta.push_back('\n');
+    subscriber.client->write(delta.data(), qint64(delta.size()));
+    subscriber.client->flush();
+}
+
+// Бинарный клиент начинает с HELLO, всё остальное — старый JSON-протокол.
+// false — данных пока не хватает, чтобы решить.
+static bool negotiate(QTcpSocket* client, ClientSession& session)
+{
+    const auto* bytes = reinterpret_cast<const std::uint8_t*>(session.buffer.constData());
+    std::size_t size = std::size_t(session.buffer.size());
+    std::size_t prefix = std::min<std::size_t>(size, 4);
+    if (!std::equal(bytes, bytes + prefix, binproto::MAGIC)) {
+        session.protocol = ClientSession::JSON;
+        return true;
+    }
+    if (size < binproto::HELLO_SIZE) {
+        return false;
+    }
+
+    std::uint8_t version = std::min(binproto::readHello(bytes), binproto::VERSION);
+    std::uint8_t hello[binproto::HELLO_SIZE];
+    binproto::writeHello(hello, version);
+    client->write(reinterpret_cast<const char*>(hello), sizeof(hello));
+    session.buffer.remove(0, int(binproto::HELLO_SIZE));
+    session.protocol = ClientSession::BINARY;
+    qDebug() << "[SERVER] Клиент перешёл на бинарный протокол, версия" << version;
+    return true;
+}
+
+static void appendReply(QByteArray& reply, const binproto::ReplyHeader& header)
+{
+    std::uint8_t bytes[binproto::REPLY_HEADER_SIZE];
+    binproto::encode(header, bytes);
+    reply.append(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+}
+
+// Разбирает все целые записи из буфера, на каждую отвечает ReplyHeader.
+// Команды применяются сразу, тик делает таймер сервера.
+static void handleBinary(QTcpSocket* client, ClientSession& session, Scene& scene, CommandHandler& handler)
+{
+    CommandDecoder decoder(scene.getPrefabs());
+    const auto* bytes = reinterpret_cast<const std::uint8_t*>(session.buffer.constData());
+    std::size_t size = std::size_t(session.buffer.size());
+    std::size_t offset = 0;
+    session.reply.resize(0);
+
+    for (; size - offset >= binproto::RECORD_SIZE; offset += binproto::RECORD_SIZE) {
+        binproto::CommandRecord record = binproto::decodeRecord(bytes + offset);
+        binproto::ReplyHeader header;
+        header.sequence = record.sequence;
+        header.op = record.op;
+
+        if (record.op == binproto::Op::GET_STATE) {
+            serializeScene(scene, session.state);
+            header.payloadSize = std::uint32_t(session.state.size());
+            appendReply(session.reply, header);
+            session.reply.append(session.state.data(), int(session.state.size()));
+            continue;
         }
 
-        float hp = scene.hasComponent<HealthComponent>(entity)
-                       ? scene.getComponent<HealthComponent>(entity).health : 0;
-
-        state["entities"].push_back(json{
-            {"id", entity},
-            {"type", type},
-            {"x", transform.position.x},
-            {"y", transform.position.y},
-            {"hp", hp},
-            {"texture", texture},
-            {"width", width},
-            {"height", height}
-        });
+        SimCommand command;
+        header.status = decoder.decode(record, command);
+        if (header.status == binproto::Status::OK) {
+            handler.apply(command, scene);
+        }
+        appendReply(session.reply, header);
+    }
+
+    session.buffer.remove(0, int(offset));
+    if (!session.reply.isEmpty()) {
+        client->write(session.reply);
+        client->flush();
     }
-    return state;
 }
 
+// "get_state x0 y0 x1 y1" — состояние только видимой клиенту области
+// (углы прямоугольника в мировых координатах, в любом порядке)
+static bool parseViewRect(const QByteArray& data, WorldRect& view)
+{
+    QList<QByteArray> parts = data.simplified().split(' ');
+    if (parts.size() != 5 || parts[0] != "get_state") return false;
+    float v[4];
+    for (int i = 0; i < 4; ++i) {
+        bool ok = false;
+        v[i] = parts[i + 1].toFloat(&ok);
+        if (!ok) return false;
+    }
+    view = {std::min(v[0], v[2]), std::min(v[1], v[3]), std::max(v[0], v[2]), std::max(v[1], v[3])};
+    return true;
+}
+
+// Каждый JSON-ответ завершается '\n' (в самом JSON переводов строк нет),
+// чтобы клиент мог отделить один ответ от другого в потоке TCP
+static void handleJson(QTcpSocket* client, ClientSession& session, const QByteArray& data,
+                       Scene& scene, CommandHandler& handler)
+{
+    qDebug() << "[SERVER] Получены данные от клиента (size:" << data.size() << "):" << data;
+    std::pmr::string& state = session.state;
+
+    // Проверка: команда или запрос состояния?
+    WorldRect view;
+    bool culled = parseViewRect(data, view);
+    if (culled || data == "get_state" || data == "{}") {
+        // Кадр зрителя только режет ответ. Камеру сцены (а с ней грубую
+        // симуляцию вне кадра) он не трогает: иначе то, как идёт бой,
+        // зависело бы от того, кто и куда смотрит.
+        if (culled) {
+            serializeScene(scene, view, state);
+        } else {
+            serializeScene(scene, state);
+        }
+        state.push_back('\n');
+        client->write(state.data(), qint64(state.size()));
+        client->flush();
+        qDebug() << "[SERVER] GUI-клиент запросил состояние, отправлен ответ.";
+        return;
+    }
+
+    try {
+        // SAX-разбор прямо из буфера QByteArray, без std::string и DOM
+        handler.handle(data.constData(), std::size_t(data.size()), scene);
+        qDebug() << "[SERVER] JSON принят, команд:" << handler.lastCommandCount();
+        scene.update();
+        serializeScene(scene, state);
+        state.push_back('\n');
+        client->write(state.data(), qint64(state.size()));
+        client->flush();
+        qDebug() << "[SERVER] Ответ отправлен клиенту (size:" << state.size() << ")";
+    } catch (const std::exception& e) {
+        QByteArray err = QString("JSON parse error: %1\n").arg(e.what()).toUtf8();
+        client->write(err);
+        client->flush();
+        qDebug() << "[SERVER] Ошибка парсинга JSON:" << e.what();
+    }
+}
+
+// Кадр подробной симуляции по умолчанию: середина карты путей, по половине
+// её ширины и высоты. Юниты на краях карты (подходящие подкрепления,
+// отставшие) ищут цель и проверяют столкновения реже (см. VisibilitySystem).
+static void defaultSimulationView(float& centerX, float& centerY, float& halfSize)
+{
+    NavGridConfig map;
+    float width = map.width * map.cellSize;
+    float height = map.height * map.cellSize;
+    centerX = map.minX + width / 2;
+    centerY = map.minY + height / 2;
+    halfSize = std::min(width, height) / 4;
+}
+
+// "x,y" -> два числа; false — не разобрать
+static bool parsePoint(const QString& text, float& x, float& y)
+{
+    const QStringList parts = text.split(',');
+    if (parts.size() != 2) return false;
+    bool okX = false;
+    bool okY = false;
+    x = parts[0].trimmed().toFloat(&okX);
+    y = parts[1].trimmed().toFloat(&okY);
+    return okX && okY;
+}
 
 int main(int argc, char *argv[]) {
     QCoreApplication app(argc, argv);
 
+    float viewX = 0.0f;
+    float viewY = 0.0f;
+    float viewHalfSize = 0.0f;
+    defaultSimulationView(viewX, viewY, viewHalfSize);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Engine server.");
+    parser.addHelpOption();
+    QCommandLineOption viewCenterOption("sim-center", "Center of the fully simulated area.", "x,y",
+                                        QString("%1,%2").arg(viewX).arg(viewY));
+    QCommandLineOption viewSizeOption("sim-half-size",
+                                      "Half the side of the fully simulated area; 0 simulates everything fully.",
+                                      "size", QString::number(viewHalfSize));
+    parser.addOptions({ viewCenterOption, viewSizeOption });
+    parser.process(app);
+
+    bool sizeOk = false;
+    viewHalfSize = parser.value(viewSizeOption).toFloat(&sizeOk);
+    if (!parsePoint(parser.value(viewCenterOption), viewX, viewY) || !sizeOk) {
+        qDebug() << "Неверные --sim-center / --sim-half-size";
+        return 1;
+    }
+
     QTcpServer server;
     Scene scene;
     CommandHandler handler;
 
+    // Камера сцены задаёт только, где симуляция подробная; кадры зрителей
+    // её не трогают (см. handleJson)
+    scene.getCamera().setPosition(Point(viewX, viewY));
+    scene.getCamera().setViewHalfSize(viewHalfSize);
+    if (viewHalfSize > 0.0f) {
+        qDebug() << "[SERVER] Подробная симуляция в кадре" << viewX << viewY << "±" << viewHalfSize;
+    } else {
+        qDebug() << "[SERVER] Подробная симуляция на всей карте";
+    }
+
+    // Типы юнитов для summon
+    QFile prefabFile(":/data/prefabs.json");
+    if (!prefabFile.open(QIODevice::ReadOnly)) {
+        qDebug() << "Не удалось открыть prefabs.json!";
+        return 1;
+    }
+    try {
+        QByteArray prefabData = prefabFile.readAll();
+        auto loaded = scene.getPrefabs().load(
+            json::parse(prefabData.constData(), prefabData.constData() + prefabData.size()),
+            scene.getAssets());
+        qDebug() << "[SERVER] Загружено префабов:" << loaded;
+    } catch (const std::exception& e) {
+        qDebug() << "Ошибка загрузки prefabs.json:" << e.what();
+        return 1;
+    }
+
+    std::vector<Subscriber> subscribers;
+    int tick = 0;
+
     QTimer updateTimer;
-    QObject::connect(&updateTimer, &QTimer::timeout, [&scene]() {
+    QObject::connect(&updateTimer, &QTimer::timeout, [&scene, &subscribers, &tick]() {
         scene.update();
+        if (++tick % STREAM_INTERVAL_TICKS != 0) return;
+        for (const auto& subscriber : subscribers) {
+            pushDelta(subscriber, scene);
+        }
     });
     updateTimer.start(16);
 
@@ -64,40 +283,42 @@ int main(int argc, char *argv[]) {
     QObject::connect(&server, &QTcpServer::newConnection, [&]() {
         QTcpSocket *client = server.nextPendingConnection();
         qDebug() << "[SERVER] Новый клиент подключился:" << client;
-        QObject::connect(client, &QTcpSocket::readyRead, [client, &scene, &handler]() {
+        auto session = std::make_shared<ClientSession>();
+        QObject::connect(client, &QTcpSocket::readyRead, [client, session, &scene, &handler, &subscribers]() {
             qDebug() << "[SERVER] readyRead, bytesAvailable:" << client->bytesAvailable();
             QByteArray data = client->readAll();
-            qDebug() << "[SERVER] Получены данные от клиента (size:" << data.size() << "):" << data;
-
-            // Проверка: команда или запрос состояния?
-            if (data == "get_state" || data == "{}") {
-                json state = serializeScene(scene);
-                QByteArray reply = QString::fromStdString(state.dump()).toUtf8();
-                client->write(reply);
-                client->flush();
-                qDebug() << "[SERVER] GUI-клиент запросил состояние, отправлен ответ.";
-                return;
+
+            if (session->protocol == ClientSession::UNKNOWN) {
+                session->buffer.append(data);
+                if (!negotiate(client, *session)) return; // ждём остаток HELLO
+                if (session->protocol == ClientSession::JSON) {
+                    data = session->buffer;
+                    session->buffer.clear();
+                }
+            } else if (session->protocol == ClientSession::BINARY) {
+                session->buffer.append(data);
             }
 
-            try {
-                json cmd = json::parse(data.toStdString());
-                qDebug() << "[SERVER] JSON принят, команд:" << (cmd.contains("commands") ? cmd["commands"].size() : 0);
-                handler.handle(cmd, scene);
-                scene.update();
-                json state = serializeScene(scene);
-                QByteArray reply = QString::fromStdString(state.dump()).toUtf8();
-                client->write(reply);
-                client->flush();
-                qDebug() << "[SERVER] Ответ отправлен клиенту (size:" << reply.size() << ")";
-            } catch (const std::exception& e) {
-                QByteArray err = QString("JSON parse error: %1").arg(e.what()).toUtf8();
-                client->write(err);
-                client->flush();
-                qDebug() << "[SERVER] Ошибка парсинга JSON:" << e.what();
+            if (session->protocol == ClientSession::BINARY) {
+                handleBinary(client, *session, scene, handler);
+            } else if (data == "subscribe") {
+                // Вместо опроса get_state: сразу вся сцена, дальше только дельты
+                // Повторная подписка — пересинхронизация с нуля
+                if (!session->stream) {
+                    subscribers.push_back({client, session});
+                    qDebug() << "[SERVER] Клиент подписался на дельты состояния";
+                }
+                session->stream = std::make_unique<StateDeltaTracker>();
+                pushDelta({client, session}, scene);
+            } else {
+                handleJson(client, *session, data, scene, handler);
             }
         });
-        QObject::connect(client, &QTcpSocket::disconnected, [client]() {
+        QObject::connect(client, &QTcpSocket::disconnected, [client, &subscribers]() {
             qDebug() << "[SERVER] Клиент отключился:" << client;
+            subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(),
+                                             [client](const Subscriber& s) { return s.client == client; }),
+                              subscribers.end());
             client->deleteLater();
         });
     });
@@ -0,0 +1,69 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <memory_resource>
+#include <memory>
+#include <cstddef>
+
+// Монотонная арена на один тик: временные контейнеры (списки сущностей,
+// буфер сериализации) берут память отсюда, а reset() в конце тика
+// отдаёт всё разом, без обращений к глобальному аллокатору.
+class FrameArena {
+public:
+    explicit FrameArena(std::size_t initialCapacity = 256 * 1024)
+    {
+        allocateBuffer(initialCapacity);
+    }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return arena.get(); }
+
+    // Если за тик буфера не хватило (пришлось занимать у кучи),
+    // буфер увеличивается, и следующий тик снова обходится без кучи
+    void reset() {
+        if (overflow.overflowBytes > 0) {
+            std::size_t needed = capacity + overflow.overflowBytes;
+            std::size_t newCapacity = capacity * 2;
+            while (newCapacity < needed) newCapacity *= 2;
+            arena.reset();
+            allocateBuffer(newCapacity);
+        } else {
+            arena->release();
+        }
+        overflow.overflowBytes = 0;
+    }
+
+    std::size_t getCapacity() const { return capacity; }
+
+private:
+    // Считает, сколько байт арена попросила сверх своего буфера
+    struct OverflowCounter : std::pmr::memory_resource {
+        std::size_t overflowBytes = 0;
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            overflowBytes += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    void allocateBuffer(std::size_t newCapacity) {
+        capacity = newCapacity;
+        buffer = std::make_unique<std::byte[]>(capacity);
+        arena = std::make_unique<std::pmr::monotonic_buffer_resource>(buffer.get(), capacity, &overflow);
+    }
+
+    OverflowCounter overflow;
+    std::size_t capacity = 0;
+    std::unique_ptr<std::byte[]> buffer;
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+};
+
+#endif // FRAMEARENA_H
@@ -9,31 +9,56 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    commanddecoder.cpp \
     entitybuilder.cpp \
     camera/camera2d.cpp \
     main.cpp \
     mainwindow.cpp \
+    navigation/FlowField.cpp \
+    navigation/HierarchicalPathfinder.cpp \
+    navigation/PathWorkers.cpp \
     point/point.cpp \
+    prefabs/PrefabRegistry.cpp \
     scene/scene.cpp \
+    stateserializer.cpp \
 
 HEADERS += \
+    CommandBuffer.h \
     Event.h \
+    assets/AssetRegistry.h \
+    assets/NameTable.h \
     EventBus.h \
+    EventChannel.h \
     InputManager.h \
+    commanddecoder.h \
     commandhandler.h \
     components/ComponentManager.h \
+    components/ResourceMap.h \
+    entity/ActivitySet.h \
     entity/Entity.h \
     entity/EntityManager.h \
+    entity/EntitySet.h \
     entitybuilder.h \
     json.hpp \
     labels.h \
     meshUtils.h \
+    memory/FrameArena.h \
     systems/Systems.h \
     components/components.h \
     camera/camera2d.h \
     mainwindow.h \
+    navigation/FlowField.h \
+    navigation/HierarchicalPathfinder.h \
+    navigation/NavGrid.h \
+    navigation/PathWorkers.h \
     point/point.h \
+    prefabs/Formation.h \
+    protocol/BinaryProtocol.h \
+    prefabs/PrefabRegistry.h \
     scene/scene.h \
+    simcommand.h \
+    spatial/SpatialGrid.h \
+    stateserializer.h \
 
 LIBS += -lopengl32
 
@@ -47,3 +72,6 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 
 RESOURCES += \
     resources.qrc
+
+DISTFILES += \
+    prefabs.json
@@ -0,0 +1,164 @@
+#include "FlowField.h"
+#include <cmath>
+#include <cassert>
+
+namespace {
+
+// Сначала 4 прямых соседа, затем диагонали: при равных расстояниях
+// выбирается прямой шаг
+struct Step { int dx, dy; };
+const Step NEIGHBOURS[8] = {
+    {1, 0}, {-1, 0}, {0, 1}, {0, -1},
+    {1, 1}, {-1, 1}, {1, -1}, {-1, -1},
+};
+const std::uint8_t NO_DIRECTION = 8;
+
+}
+
+void FlowField::compute(const NavGrid& grid, const std::vector<int>& goals)
+{
+    const int width = grid.width();
+    const int height = grid.height();
+    distances.assign(std::size_t(grid.cellCount()), UNREACHABLE);
+    directions.assign(std::size_t(grid.cellCount()), NO_DIRECTION);
+
+    // Интеграционное поле: BFS по прямым соседям от всех целей сразу.
+    // Из занятой клетки (цель внутри форта) можно шагнуть в любую соседнюю:
+    // поле растекается по препятствию цели до его края и дальше по свободным.
+    queue.clear();
+    queue.reserve(std::size_t(grid.cellCount()));
+    for (int goal : goals) {
+        if (goal < 0 || goal >= grid.cellCount() || distances[std::size_t(goal)] == 0) continue;
+        distances[std::size_t(goal)] = 0;
+        queue.push_back(goal);
+    }
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        int cell = queue[head];
+        int x = cell % width;
+        int y = cell / width;
+        std::uint16_t next = std::uint16_t(std::min<int>(distances[std::size_t(cell)] + 1, UNREACHABLE - 1));
+        for (int i = 0; i < 4; ++i) {
+            int nx = x + NEIGHBOURS[i].dx;
+            int ny = y + NEIGHBOURS[i].dy;
+            if (!grid.contains(nx, ny)) continue;
+            if (grid.isBlocked(nx, ny) && !grid.isBlocked(cell)) continue;
+            int neighbour = grid.index(nx, ny);
+            if (distances[std::size_t(neighbour)] != UNREACHABLE) continue;
+            distances[std::size_t(neighbour)] = next;
+            queue.push_back(neighbour);
+        }
+    }
+
+    // Поле направлений: шаг к соседу с наименьшим расстоянием. По диагонали —
+    // только если оба прямых соседа свободны, иначе юнит срежет угол стены.
+    // Занятые клетки тоже получают направление: юнита, прижатого к стене,
+    // выводит наружу.
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            int cell = grid.index(x, y);
+            std::uint16_t best = distances[std::size_t(cell)];
+            if (best == 0) continue;
+            bool free = !grid.isBlocked(cell);
+            for (std::uint8_t i = 0; i < 8; ++i) {
+                int nx = x + NEIGHBOURS[i].dx;
+                int ny = y + NEIGHBOURS[i].dy;
+                if (!grid.contains(nx, ny)) continue;
+                if (free && i >= 4 && (grid.isBlocked(nx, y) || grid.isBlocked(x, ny))) continue;
+                std::uint16_t d = distances[std::size_t(grid.index(nx, ny))];
+                if (d < best) {
+                    best = d;
+                    directions[std::size_t(cell)] = i;
+                }
+            }
+        }
+    }
+}
+
+bool FlowField::sample(const NavGrid& grid, const Point& position, Point& direction) const
+{
+    if (directions.empty()) return false;
+    int cell = grid.cellAt(position);
+    if (cell < 0) return false;
+    std::uint8_t i = directions[std::size_t(cell)];
+    if (i == NO_DIRECTION) return false;
+    const float diagonal = 1.0f / std::sqrt(2.0f);
+    float scale = i >= 4 ? diagonal : 1.0f;
+    direction = Point(NEIGHBOURS[i].dx * scale, NEIGHBOURS[i].dy * scale);
+    return true;
+}
+
+FlowFieldWorker::FlowFieldWorker()
+    : thread(&FlowFieldWorker::run, this)
+{
+}
+
+FlowFieldWorker::~FlowFieldWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    thread.join();
+}
+
+FlowFieldWorker::Job& FlowFieldWorker::prepareJob(const NavGridConfig& config)
+{
+    assert(!submitted && "Previous flow field result was not taken.");
+    job.grid.reset(config);
+    for (auto& goals : job.goals) {
+        goals.clear();
+    }
+    return job;
+}
+
+void FlowFieldWorker::submit()
+{
+    assert(!submitted && "Previous flow field result was not taken.");
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = true;
+        ready = false;
+    }
+    submitted = true;
+    wake.notify_all();
+}
+
+const FlowFieldWorker::Result* FlowFieldWorker::takeResult()
+{
+    if (!submitted) return nullptr;
+    std::unique_lock<std::mutex> lock(mutex);
+    wake.wait(lock, [this] { return ready; });
+    submitted = false;
+    ready = false;
+    // следующий расчёт пойдёт в другой буфер, этот остаётся тику
+    const Result* result = &results[back];
+    back ^= 1;
+    return result;
+}
+
+void FlowFieldWorker::run()
+{
+    for (;;) {
+        Result* result;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || pending; });
+            if (stopping) return;
+            pending = false;
+            result = &results[back];
+        }
+
+        // Пока задание не досчитано, тик не трогает ни job, ни results[back]
+        result->grid = job.grid;
+        for (int team = 0; team < TEAM_COUNT; ++team) {
+            result->fields[team].compute(job.grid, job.goals[team]);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready = true;
+        }
+        wake.notify_all();
+    }
+}
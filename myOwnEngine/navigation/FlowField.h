@@ -0,0 +1,86 @@
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include <vector>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "navigation/NavGrid.h"
+
+// Поле направлений к ближайшей цели сразу для всех клеток карты.
+// Один BFS от всех целей (интеграционное поле — расстояние в клетках),
+// затем в каждой клетке запоминается шаг к соседу с наименьшим расстоянием.
+// Сколько бы юнитов ни шло к целям, каждому — O(1) выборка по клетке.
+class FlowField {
+public:
+    static constexpr std::uint16_t UNREACHABLE = 0xFFFF;
+
+    // goals — индексы клеток целей; цель может стоять и в занятой клетке
+    // (например, форт), поле тогда ведёт к её краю
+    void compute(const NavGrid& grid, const std::vector<int>& goals);
+
+    // Единичное направление движения в точке. false — точка вне карты,
+    // цель недостижима или точка уже в клетке цели.
+    bool sample(const NavGrid& grid, const Point& position, Point& direction) const;
+
+    std::uint16_t distance(int cell) const { return distances[std::size_t(cell)]; }
+    bool empty() const { return distances.empty(); }
+
+private:
+    std::vector<std::uint16_t> distances;
+    std::vector<std::uint8_t> directions; // индекс в NEIGHBOURS, NO_DIRECTION — стоять
+    std::vector<int> queue;               // очередь BFS, между расчётами хранит ёмкость
+};
+
+// Считает поля в фоновом потоке. Тик отдаёт задание (копию карты и клеток
+// целей) и продолжает симуляцию; расчёт не трогает компоненты сцены.
+// Результат забирается через фиксированное число тиков, а не "когда
+// готов": так симуляция не зависит от того, как быстро успел поток.
+// Задание и результаты живут в буферах воркера и переиспользуются:
+// после первых расчётов новые поля кучу не трогают.
+class FlowFieldWorker {
+public:
+    static constexpr int TEAM_COUNT = 2; // по TeamComponent::Team
+
+    struct Job {
+        NavGrid grid;
+        std::vector<int> goals[TEAM_COUNT]; // для команды t — клетки её противников
+    };
+    struct Result {
+        NavGrid grid;
+        FlowField fields[TEAM_COUNT];
+    };
+
+    FlowFieldWorker();
+    ~FlowFieldWorker();
+    FlowFieldWorker(const FlowFieldWorker&) = delete;
+    FlowFieldWorker& operator=(const FlowFieldWorker&) = delete;
+
+    // Пустое задание с картой размера config — заполнить и отдать через
+    // submit(). Предыдущий результат должен быть уже забран.
+    Job& prepareJob(const NavGridConfig& config);
+    void submit();
+    bool hasJob() const { return submitted; }
+    // Результат отданного задания. Если поток ещё считает — ждёт его
+    // (BFS по карте — доли миллисекунды, к моменту забора он давно готов).
+    // Указатель годен до следующего takeResult: результаты пишутся
+    // в два буфера попеременно.
+    const Result* takeResult();
+
+private:
+    void run();
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    Job job;
+    Result results[2];
+    int back = 0;           // буфер, в который считает поток
+    bool pending = false;   // задание отдано, поток его ещё не взял
+    bool ready = false;     // results[back] досчитан
+    bool submitted = false; // только поток тика
+    bool stopping = false;
+    std::thread thread; // последним: стартует, когда остальное уже создано
+};
+
+#endif // FLOWFIELD_H
@@ -0,0 +1,393 @@
+#include "HierarchicalPathfinder.h"
+#include <queue>
+#include <climits>
+#include <cstdlib>
+#include <algorithm>
+
+namespace {
+
+const int DX[4] = {1, -1, 0, 0};
+const int DY[4] = {0, 0, 1, -1};
+
+// Насколько далеко искать свободную клетку рядом с занятой (в клетках):
+// форт 2×2 с раздувом на радиус юнита — около 3 клеток от центра до края
+const int MAX_SNAP = 8;
+// Сколько клеток вперёд проверяет сглаживание пути
+const int SMOOTH_LOOKAHEAD = 24;
+
+}
+
+HierarchicalPathfinder::HierarchicalPathfinder(const NavGrid& grid)
+    : grid(grid),
+      clustersX((grid.width() + CLUSTER_SIZE - 1) / CLUSTER_SIZE),
+      clustersY((grid.height() + CLUSTER_SIZE - 1) / CLUSTER_SIZE),
+      cellNode(std::size_t(grid.cellCount()), -1),
+      clusterNodes(std::size_t(clustersX * clustersY))
+{
+    buildEntrances();
+    buildIntraEdges();
+}
+
+int HierarchicalPathfinder::clusterOf(int cell) const
+{
+    int x = cell % grid.width();
+    int y = cell / grid.width();
+    return (y / CLUSTER_SIZE) * clustersX + x / CLUSTER_SIZE;
+}
+
+void HierarchicalPathfinder::clusterBounds(int cluster, int& x0, int& y0, int& x1, int& y1) const
+{
+    x0 = (cluster % clustersX) * CLUSTER_SIZE;
+    y0 = (cluster / clustersX) * CLUSTER_SIZE;
+    x1 = std::min(x0 + CLUSTER_SIZE, grid.width());
+    y1 = std::min(y0 + CLUSTER_SIZE, grid.height());
+}
+
+int HierarchicalPathfinder::localIndex(int cell, int cluster) const
+{
+    int x = cell % grid.width() - (cluster % clustersX) * CLUSTER_SIZE;
+    int y = cell / grid.width() - (cluster / clustersX) * CLUSTER_SIZE;
+    return y * CLUSTER_SIZE + x;
+}
+
+int HierarchicalPathfinder::nodeAtCell(int cell)
+{
+    int& node = cellNode[std::size_t(cell)];
+    if (node < 0) {
+        node = int(nodes.size());
+        nodes.push_back(Node{cell, clusterOf(cell), {}});
+        clusterNodes[std::size_t(nodes.back().cluster)].push_back(node);
+    }
+    return node;
+}
+
+void HierarchicalPathfinder::addEntrance(int cellA, int cellB)
+{
+    int a = nodeAtCell(cellA);
+    int b = nodeAtCell(cellB);
+    nodes[std::size_t(a)].edges.push_back(Edge{b, 1, -1});
+    nodes[std::size_t(b)].edges.push_back(Edge{a, 1, -1});
+}
+
+void HierarchicalPathfinder::buildEntrances()
+{
+    // Вдоль каждой общей границы — отрезки, где свободны клетки с обеих
+    // сторон. Короткий отрезок — один вход посередине, длинный — два по краям.
+    auto emitRuns = [this](int length, auto cellsAt) {
+        int runStart = -1;
+        for (int i = 0; i <= length; ++i) {
+            bool open = false;
+            if (i < length) {
+                auto cells = cellsAt(i);
+                open = !grid.isBlocked(cells.first) && !grid.isBlocked(cells.second);
+            }
+            if (open && runStart < 0) runStart = i;
+            if (open || runStart < 0) continue;
+            int runEnd = i - 1;
+            if (runEnd - runStart + 1 >= WIDE_ENTRANCE) {
+                auto first = cellsAt(runStart);
+                auto last = cellsAt(runEnd);
+                addEntrance(first.first, first.second);
+                addEntrance(last.first, last.second);
+            } else {
+                auto middle = cellsAt((runStart + runEnd) / 2);
+                addEntrance(middle.first, middle.second);
+            }
+            runStart = -1;
+        }
+    };
+
+    for (int cy = 0; cy < clustersY; ++cy) {
+        for (int cx = 0; cx < clustersX; ++cx) {
+            int x0 = cx * CLUSTER_SIZE;
+            int y0 = cy * CLUSTER_SIZE;
+            if (cx + 1 < clustersX) {
+                int x = x0 + CLUSTER_SIZE - 1;
+                int length = std::min(CLUSTER_SIZE, grid.height() - y0);
+                emitRuns(length, [&](int i) {
+                    return std::make_pair(grid.index(x, y0 + i), grid.index(x + 1, y0 + i));
+                });
+            }
+            if (cy + 1 < clustersY) {
+                int y = y0 + CLUSTER_SIZE - 1;
+                int length = std::min(CLUSTER_SIZE, grid.width() - x0);
+                emitRuns(length, [&](int i) {
+                    return std::make_pair(grid.index(x0 + i, y), grid.index(x0 + i, y + 1));
+                });
+            }
+        }
+    }
+}
+
+void HierarchicalPathfinder::clusterBfs(int from, int cluster, std::vector<int>& dist, std::vector<int>& parent) const
+{
+    int x0, y0, x1, y1;
+    clusterBounds(cluster, x0, y0, x1, y1);
+    dist.assign(std::size_t(CLUSTER_SIZE * CLUSTER_SIZE), -1);
+    parent.assign(std::size_t(CLUSTER_SIZE * CLUSTER_SIZE), -1);
+
+    std::vector<int> queue;
+    queue.reserve(std::size_t(CLUSTER_SIZE * CLUSTER_SIZE));
+    dist[std::size_t(localIndex(from, cluster))] = 0;
+    queue.push_back(from);
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        int cell = queue[head];
+        int x = cell % grid.width();
+        int y = cell / grid.width();
+        int next = dist[std::size_t(localIndex(cell, cluster))] + 1;
+        for (int i = 0; i < 4; ++i) {
+            int nx = x + DX[i];
+            int ny = y + DY[i];
+            if (nx < x0 || ny < y0 || nx >= x1 || ny >= y1 || grid.isBlocked(nx, ny)) continue;
+            int neighbour = grid.index(nx, ny);
+            std::size_t local = std::size_t(localIndex(neighbour, cluster));
+            if (dist[local] >= 0) continue;
+            dist[local] = next;
+            parent[local] = cell;
+            queue.push_back(neighbour);
+        }
+    }
+}
+
+void HierarchicalPathfinder::buildIntraEdges()
+{
+    std::vector<int> dist;
+    std::vector<int> parent;
+    for (std::size_t cluster = 0; cluster < clusterNodes.size(); ++cluster) {
+        const std::vector<int>& members = clusterNodes[cluster];
+        for (int from : members) {
+            clusterBfs(nodes[std::size_t(from)].cell, int(cluster), dist, parent);
+            for (int to : members) {
+                if (to == from) continue;
+                int cell = nodes[std::size_t(to)].cell;
+                int cost = dist[std::size_t(localIndex(cell, int(cluster)))];
+                if (cost < 0) continue;
+
+                std::vector<int> path;
+                for (int c = cell; c != nodes[std::size_t(from)].cell;
+                     c = parent[std::size_t(localIndex(c, int(cluster)))]) {
+                    path.push_back(c);
+                }
+                std::reverse(path.begin(), path.end());
+                nodes[std::size_t(from)].edges.push_back(Edge{to, cost, int(intraPaths.size())});
+                intraPaths.push_back(std::move(path));
+            }
+        }
+    }
+}
+
+bool HierarchicalPathfinder::localPath(int from, int to, int cluster, std::vector<int>& cells) const
+{
+    if (from == to) return true;
+    std::vector<int> dist;
+    std::vector<int> parent;
+    clusterBfs(from, cluster, dist, parent);
+    if (dist[std::size_t(localIndex(to, cluster))] < 0) return false;
+
+    std::size_t begin = cells.size();
+    for (int c = to; c != from; c = parent[std::size_t(localIndex(c, cluster))]) {
+        cells.push_back(c);
+    }
+    std::reverse(cells.begin() + std::ptrdiff_t(begin), cells.end());
+    return true;
+}
+
+int HierarchicalPathfinder::nearestFree(int cell) const
+{
+    if (!grid.isBlocked(cell)) return cell;
+    int x = cell % grid.width();
+    int y = cell / grid.width();
+    for (int r = 1; r <= MAX_SNAP; ++r) {
+        int best = -1;
+        int bestDistance = INT_MAX;
+        for (int dy = -r; dy <= r; ++dy) {
+            for (int dx = -r; dx <= r; ++dx) {
+                if (std::abs(dx) != r && std::abs(dy) != r) continue; // только кольцо
+                if (grid.isBlocked(x + dx, y + dy)) continue;
+                int d = dx * dx + dy * dy;
+                if (d < bestDistance) {
+                    bestDistance = d;
+                    best = grid.index(x + dx, y + dy);
+                }
+            }
+        }
+        if (best >= 0) return best;
+    }
+    return -1;
+}
+
+bool HierarchicalPathfinder::abstractSearch(int start, int goal, std::vector<int>& chain) const
+{
+    const int startCluster = clusterOf(start);
+    const int goalCluster = clusterOf(goal);
+    std::vector<int> startDist, goalDist, parentScratch;
+    clusterBfs(start, startCluster, startDist, parentScratch);
+    clusterBfs(goal, goalCluster, goalDist, parentScratch);
+
+    const int goalX = goal % grid.width();
+    const int goalY = goal / grid.width();
+    auto heuristic = [&](int node) {
+        int cell = nodes[std::size_t(node)].cell;
+        return std::abs(cell % grid.width() - goalX) + std::abs(cell / grid.width() - goalY);
+    };
+
+    // Узел nodes.size() — сама цель: в неё ведут входы кластера цели,
+    // из которых до неё можно дойти внутри кластера
+    const int target = int(nodes.size());
+    std::vector<int> g(nodes.size() + 1, INT_MAX);
+    std::vector<int> parent(nodes.size() + 1, -1);
+    std::vector<char> closed(nodes.size() + 1, 0);
+    using Entry = std::pair<int, int>; // f, узел
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+
+    for (int node : clusterNodes[std::size_t(startCluster)]) {
+        int d = startDist[std::size_t(localIndex(nodes[std::size_t(node)].cell, startCluster))];
+        if (d < 0) continue;
+        g[std::size_t(node)] = d;
+        open.push(Entry(d + heuristic(node), node));
+    }
+
+    while (!open.empty()) {
+        int node = open.top().second;
+        open.pop();
+        if (closed[std::size_t(node)]) continue;
+        closed[std::size_t(node)] = 1;
+        if (node == target) break;
+
+        const Node& n = nodes[std::size_t(node)];
+        int base = g[std::size_t(node)];
+        if (n.cluster == goalCluster) {
+            int d = goalDist[std::size_t(localIndex(n.cell, goalCluster))];
+            if (d >= 0 && base + d < g[std::size_t(target)]) {
+                g[std::size_t(target)] = base + d;
+                parent[std::size_t(target)] = node;
+                open.push(Entry(base + d, target));
+            }
+        }
+        for (const Edge& edge : n.edges) {
+            int cost = base + edge.cost;
+            if (closed[std::size_t(edge.to)] || cost >= g[std::size_t(edge.to)]) continue;
+            g[std::size_t(edge.to)] = cost;
+            parent[std::size_t(edge.to)] = node;
+            open.push(Entry(cost + heuristic(edge.to), edge.to));
+        }
+    }
+
+    if (g[std::size_t(target)] == INT_MAX) return false;
+    chain.clear();
+    for (int node = parent[std::size_t(target)]; node >= 0; node = parent[std::size_t(node)]) {
+        chain.push_back(node);
+    }
+    std::reverse(chain.begin(), chain.end());
+    return true;
+}
+
+void HierarchicalPathfinder::appendEdgePath(int from, int to, std::vector<int>& cells) const
+{
+    const Edge* best = nullptr;
+    for (const Edge& edge : nodes[std::size_t(from)].edges) {
+        if (edge.to == to && (!best || edge.cost < best->cost)) best = &edge;
+    }
+    if (!best || best->path < 0) {
+        cells.push_back(nodes[std::size_t(to)].cell);
+        return;
+    }
+    const std::vector<int>& path = intraPaths[std::size_t(best->path)];
+    cells.insert(cells.end(), path.begin(), path.end());
+}
+
+std::vector<Point> HierarchicalPathfinder::smooth(int start, const std::vector<int>& cells, const Point& to) const
+{
+    auto center = [this](int cell) {
+        return grid.cellCenter(cell % grid.width(), cell / grid.width());
+    };
+
+    // Из текущей точки — к самой дальней клетке пути, видимой по прямой
+    std::vector<Point> waypoints;
+    Point anchor = center(start);
+    Point previous = anchor;
+    std::size_t i = 0;
+    while (i < cells.size()) {
+        std::size_t limit = std::min(cells.size(), i + SMOOTH_LOOKAHEAD);
+        std::size_t best = i;
+        for (std::size_t j = i + 1; j < limit; ++j) {
+            if (grid.isPathClear(anchor, center(cells[j]))) best = j;
+        }
+        previous = anchor;
+        anchor = center(cells[best]);
+        waypoints.push_back(anchor);
+        i = best + 1;
+    }
+
+    // Последняя точка — сама цель, а не центр её клетки, если к ней
+    // так же свободный проход
+    if (!waypoints.empty() && grid.cellAt(waypoints.back()) == grid.cellAt(to) &&
+        grid.isPathClear(previous, to)) {
+        waypoints.back() = to;
+    } else {
+        waypoints.push_back(to);
+    }
+    return waypoints;
+}
+
+std::vector<Point> HierarchicalPathfinder::findPath(const Point& from, const Point& to,
+                                                   std::uint32_t cacheVersion, Route* found) const
+{
+    int start = grid.cellAt(from);
+    int goal = grid.cellAt(to);
+    if (start < 0 || goal < 0) return {};
+    start = nearestFree(start);
+    goal = nearestFree(goal);
+    if (start < 0 || goal < 0) return {};
+    if (start == goal) return {to};
+
+    const int startCluster = clusterOf(start);
+    const int goalCluster = clusterOf(goal);
+    std::vector<int> cells;
+    if (startCluster == goalCluster && localPath(start, goal, startCluster, cells)) {
+        return smooth(start, cells, to);
+    }
+
+    auto assemble = [&](const std::vector<int>& chain) {
+        cells.clear();
+        if (chain.empty()) return false;
+        if (!localPath(start, nodes[std::size_t(chain.front())].cell, startCluster, cells)) return false;
+        for (std::size_t i = 0; i + 1 < chain.size(); ++i) {
+            appendEdgePath(chain[i], chain[i + 1], cells);
+        }
+        return localPath(nodes[std::size_t(chain.back())].cell, goal, goalCluster, cells);
+    };
+
+    // Маршрут по входам для этой пары кластеров уже искали. Он годится,
+    // если из нашей клетки дойти до его первого входа, а от последнего — до цели.
+    const std::uint32_t key = std::uint32_t(startCluster) << 16 | std::uint32_t(goalCluster);
+    const bool cacheable = startCluster != goalCluster;
+    std::vector<int> chain;
+    if (cacheable && cacheVersion > 0) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = routeCache.find(key);
+        if (it != routeCache.end() && it->second.version <= cacheVersion) chain = it->second.chain;
+    }
+    if (!assemble(chain)) {
+        if (!abstractSearch(start, goal, chain) || !assemble(chain)) return {};
+        if (cacheable && found) {
+            found->key = key;
+            found->chain = chain;
+        }
+    }
+    return smooth(start, cells, to);
+}
+
+std::uint32_t HierarchicalPathfinder::routeCount() const
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return std::uint32_t(routeCache.size());
+}
+
+void HierarchicalPathfinder::storeRoute(Route&& route) const
+{
+    if (route.chain.empty()) return;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    std::uint32_t version = std::uint32_t(routeCache.size()) + 1;
+    routeCache.try_emplace(route.key, CachedRoute{version, std::move(route.chain)});
+}
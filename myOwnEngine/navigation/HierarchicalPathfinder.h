@@ -0,0 +1,104 @@
+#ifndef HIERARCHICALPATHFINDER_H
+#define HIERARCHICALPATHFINDER_H
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include "navigation/NavGrid.h"
+
+// Поиск пути по карте проходимости в два уровня (HPA*). Карта режется на
+// кластеры CLUSTER_SIZE × CLUSTER_SIZE клеток; на общих границах соседних
+// кластеров выбираются входы, и пути между входами одного кластера
+// считаются один раз, при построении. Запрос — A* по небольшому графу
+// входов, затем развёртка в клетки из готовых кусков.
+//
+// Маршрут по входам кэшируется по паре (кластер старта, кластер цели):
+// юниты из одного района, идущие в другой, повторно графа не обходят.
+// Граф неизменяем после построения; findPath можно звать из нескольких
+// потоков сразу (кэш под мьютексом). Препятствия изменились — строится
+// новый объект.
+//
+// Кэш не должен делать путь зависимым от того, какой поток первым его
+// заполнил. Поэтому findPath сам в кэш не пишет: найденный маршрут он
+// отдаёт вызывающему, а тот кладёт его через storeRoute в одном потоке,
+// в порядке запросов. Каждая запись помнит свой номер, и запрос видит
+// только записи, бывшие в кэше, когда его отправили (cacheVersion).
+class HierarchicalPathfinder {
+public:
+    static constexpr int CLUSTER_SIZE = 16;
+    // Вход шире этого получает два узла по краям, а не один посередине
+    static constexpr int WIDE_ENTRANCE = 6;
+
+    // Маршрут по входам между парой кластеров, найденный поиском по графу
+    struct Route {
+        std::uint32_t key = 0;
+        std::vector<int> chain; // пусто — кэшировать нечего
+    };
+
+    explicit HierarchicalPathfinder(const NavGrid& grid);
+
+    // Точки поворота от from (не включая) до to (включая) в мировых
+    // координатах. Пусто — пути нет. Из кэша берутся только первые
+    // cacheVersion записей (0 — кэш не смотрится). Если маршрут по входам
+    // пришлось искать и found != nullptr, он возвращается в found.
+    std::vector<Point> findPath(const Point& from, const Point& to,
+                                std::uint32_t cacheVersion = 0, Route* found = nullptr) const;
+
+    // Сколько записей в кэше: это cacheVersion для запроса, отправляемого сейчас
+    std::uint32_t routeCount() const;
+    // Кладёт маршрут в кэш, если для его пары кластеров записи ещё нет
+    void storeRoute(Route&& route) const;
+
+    const NavGrid& getGrid() const { return grid; }
+    std::size_t nodeCount() const { return nodes.size(); }
+
+private:
+    struct Edge {
+        int to;
+        int cost;
+        int path; // индекс в intraPaths; -1 — переход в соседний кластер
+    };
+    struct Node {
+        int cell;
+        int cluster;
+        std::vector<Edge> edges;
+    };
+
+    void buildEntrances();
+    void addEntrance(int cellA, int cellB);
+    int nodeAtCell(int cell);
+    void buildIntraEdges();
+
+    int clusterOf(int cell) const;
+    // Клетки кластера: [x0, x1) × [y0, y1)
+    void clusterBounds(int cluster, int& x0, int& y0, int& x1, int& y1) const;
+    // BFS внутри кластера от from; dist и parent — по клеткам кластера
+    void clusterBfs(int from, int cluster, std::vector<int>& dist, std::vector<int>& parent) const;
+    int localIndex(int cell, int cluster) const;
+    // Путь внутри кластера (клетки после from, до to включительно); false — не дойти
+    bool localPath(int from, int to, int cluster, std::vector<int>& cells) const;
+    // Ближайшая свободная клетка (цель может стоять в занятой — форт)
+    int nearestFree(int cell) const;
+    // A* по графу входов; chain — узлы от входа кластера старта до входа кластера цели
+    bool abstractSearch(int start, int goal, std::vector<int>& chain) const;
+    void appendEdgePath(int from, int to, std::vector<int>& cells) const;
+    std::vector<Point> smooth(int start, const std::vector<int>& cells, const Point& to) const;
+
+    NavGrid grid;
+    int clustersX = 0;
+    int clustersY = 0;
+    std::vector<Node> nodes;
+    std::vector<int> cellNode;                 // клетка → узел или -1
+    std::vector<std::vector<int>> clusterNodes;
+    std::vector<std::vector<int>> intraPaths;  // клетки после начала ребра, до конца включительно
+
+    struct CachedRoute {
+        std::uint32_t version; // номер записи, с 1
+        std::vector<int> chain;
+    };
+    mutable std::mutex cacheMutex;
+    mutable std::unordered_map<std::uint32_t, CachedRoute> routeCache;
+};
+
+#endif // HIERARCHICALPATHFINDER_H
@@ -0,0 +1,113 @@
+#ifndef NAVGRID_H
+#define NAVGRID_H
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include "point/point.h"
+#include "spatial/SpatialGrid.h"
+
+// Размер и шаг карты проходимости
+struct NavGridConfig {
+    float minX = -32.0f;     // левый нижний угол карты в мировых координатах
+    float minY = -32.0f;
+    float cellSize = 0.5f;
+    int width = 128;         // клеток по x
+    int height = 128;        // клеток по y
+    // Препятствия раздуваются на радиус юнита: путь по свободным клеткам
+    // проходит так, что юнит целиком не задевает стену
+    float agentRadius = 0.4f;
+};
+
+// Карта проходимости для поиска пути: клетка занята, если её задевает
+// (раздутое) статичное препятствие. За пределами карты всё непроходимо.
+class NavGrid {
+public:
+    explicit NavGrid(const NavGridConfig& config = NavGridConfig())
+        : config(config), blocked(std::size_t(config.width) * config.height, 0) {}
+
+    void clear() { std::fill(blocked.begin(), blocked.end(), 0); }
+    // Пустая карта другого размера; память прежней переиспользуется
+    void reset(const NavGridConfig& newConfig) {
+        config = newConfig;
+        blocked.assign(std::size_t(config.width) * config.height, 0);
+    }
+
+    void blockRect(const WorldRect& rect) {
+        float r = config.agentRadius;
+        int x0 = std::max(0, cellX(rect.minX - r));
+        int x1 = std::min(config.width - 1, cellX(rect.maxX + r));
+        int y0 = std::max(0, cellY(rect.minY - r));
+        int y1 = std::min(config.height - 1, cellY(rect.maxY + r));
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                blocked[index(x, y)] = 1;
+            }
+        }
+    }
+
+    bool contains(int x, int y) const {
+        return x >= 0 && y >= 0 && x < config.width && y < config.height;
+    }
+    bool isBlocked(int x, int y) const {
+        return !contains(x, y) || blocked[index(x, y)] != 0;
+    }
+    bool isBlocked(int cell) const { return blocked[std::size_t(cell)] != 0; }
+
+    // Клетка, в которую попадает точка (может быть вне карты)
+    int cellX(float x) const { return toCell((x - config.minX) / config.cellSize); }
+    int cellY(float y) const { return toCell((y - config.minY) / config.cellSize); }
+    // Индекс клетки под точкой; -1 — вне карты
+    int cellAt(const Point& p) const {
+        int x = cellX(p.x);
+        int y = cellY(p.y);
+        return contains(x, y) ? index(x, y) : -1;
+    }
+
+    Point cellCenter(int x, int y) const {
+        return Point(config.minX + (x + 0.5f) * config.cellSize,
+                     config.minY + (y + 0.5f) * config.cellSize);
+    }
+
+    // Прямой путь from → to не задевает занятых клеток. Последние stopShort
+    // единиц не проверяются: цель может сама стоять в занятой клетке (форт).
+    // Шаг проверки — полклетки.
+    bool isPathClear(const Point& from, const Point& to, float stopShort = 0.0f) const {
+        float dx = to.x - from.x;
+        float dy = to.y - from.y;
+        float length = std::sqrt(dx * dx + dy * dy);
+        float checked = length - stopShort;
+        // вне карты о стенах ничего не известно
+        if (!(checked > 0.0f) || cellAt(from) < 0) return true;
+        float step = config.cellSize / 2;
+        int steps = int(std::ceil(checked / step));
+        for (int i = 1; i <= steps; ++i) {
+            float t = std::min(i * step, checked) / length;
+            if (isBlocked(cellX(from.x + dx * t), cellY(from.y + dy * t))) return false;
+        }
+        return true;
+    }
+
+    // Те же занятые клетки (при той же конфигурации)
+    bool sameCells(const NavGrid& other) const { return blocked == other.blocked; }
+
+    int index(int x, int y) const { return y * config.width + x; }
+    int width() const { return config.width; }
+    int height() const { return config.height; }
+    int cellCount() const { return config.width * config.height; }
+    const NavGridConfig& getConfig() const { return config; }
+
+private:
+    // NaN и далёкие координаты уходят за край карты
+    static int toCell(float v) {
+        if (!(v > -1.0f)) return -1;
+        if (v > 1.0e6f) return 1000000;
+        return int(std::floor(v));
+    }
+
+    NavGridConfig config;
+    std::vector<std::uint8_t> blocked;
+};
+
+#endif // NAVGRID_H
@@ -0,0 +1,89 @@
+#include "PathWorkers.h"
+#include <algorithm>
+#include <iterator>
+
+PathWorkers::PathWorkers(int threadCount)
+{
+    for (int i = 0; i < std::max(1, threadCount); ++i) {
+        threads.emplace_back(&PathWorkers::run, this);
+    }
+}
+
+PathWorkers::~PathWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void PathWorkers::submit(Request request)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Взятые запросы вычищаются, когда иначе пришлось бы расти
+        if (nextRequest > 0 && requests.size() == requests.capacity()) {
+            requests.erase(requests.begin(), requests.begin() + std::ptrdiff_t(nextRequest));
+            nextRequest = 0;
+        }
+        requests.push_back(std::move(request));
+    }
+    wake.notify_one();
+}
+
+void PathWorkers::collect(std::uint32_t lastTick, std::vector<Result>& out)
+{
+    std::size_t begin = out.size();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this, lastTick] { return dueDone(lastTick); });
+        // порядок всё равно восстанавливается сортировкой по id ниже;
+        // stable_partition взял бы временный буфер из кучи
+        auto due = std::partition(results.begin(), results.end(),
+                                  [lastTick](const Result& r) { return r.tick > lastTick; });
+        std::move(due, results.end(), std::back_inserter(out));
+        results.erase(due, results.end());
+    }
+    std::sort(out.begin() + std::ptrdiff_t(begin), out.end(),
+              [](const Result& a, const Result& b) { return a.id < b.id; });
+}
+
+bool PathWorkers::dueDone(std::uint32_t lastTick) const
+{
+    if (nextRequest < requests.size() && requests[nextRequest].tick <= lastTick) return false;
+    return std::none_of(runningTicks.begin(), runningTicks.end(),
+                        [lastTick](std::uint32_t tick) { return tick <= lastTick; });
+}
+
+void PathWorkers::run()
+{
+    for (;;) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || nextRequest < requests.size(); });
+            if (stopping) return;
+            request = std::move(requests[nextRequest++]);
+            if (nextRequest == requests.size()) {
+                requests.clear();
+                nextRequest = 0;
+            }
+            runningTicks.push_back(request.tick);
+        }
+
+        Result result{request.entity, request.id, request.tick, {}, request.pathfinder, {}};
+        result.waypoints = request.pathfinder->findPath(request.from, request.to,
+                                                        request.cacheVersion, &result.route);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            results.push_back(std::move(result));
+            runningTicks.erase(std::find(runningTicks.begin(), runningTicks.end(), request.tick));
+        }
+        finished.notify_all();
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef PATHWORKERS_H
+#define PATHWORKERS_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <cstdint>
+#include "navigation/HierarchicalPathfinder.h"
+#include "entity/Entity.h"
+
+// Пул потоков для поиска путей. Тик кладёт запросы и через несколько тиков
+// забирает ответы. Ждать ему приходится, только если потоки отстали
+// больше чем на эти несколько тиков: зато ответ всегда приходит на один
+// и тот же тик, и симуляция от скорости потоков не зависит.
+class PathWorkers {
+public:
+    struct Request {
+        Entity entity;
+        std::uint32_t id;    // растёт с каждым запросом
+        std::uint32_t tick;  // тик отправки
+        Point from;
+        Point to;
+        // Граф на момент запроса: пока поиск идёт, тик может построить новый
+        std::shared_ptr<const HierarchicalPathfinder> pathfinder;
+        std::uint32_t cacheVersion; // pathfinder->routeCount() при отправке
+    };
+    struct Result {
+        Entity entity;
+        std::uint32_t id;
+        std::uint32_t tick;
+        std::vector<Point> waypoints; // пусто — пути нет
+        // Граф запроса и найденный на нём маршрут по входам: в кэш графа
+        // его кладёт тик, когда забирает ответ
+        std::shared_ptr<const HierarchicalPathfinder> pathfinder;
+        HierarchicalPathfinder::Route route;
+    };
+
+    explicit PathWorkers(int threadCount = 2);
+    ~PathWorkers();
+    PathWorkers(const PathWorkers&) = delete;
+    PathWorkers& operator=(const PathWorkers&) = delete;
+
+    void submit(Request request);
+    // Ответы на все запросы, отправленные не позже lastTick, по
+    // возрастанию id. Ещё не готовые дожидается.
+    void collect(std::uint32_t lastTick, std::vector<Result>& out);
+
+private:
+    void run();
+    // Все запросы тиков до lastTick включительно досчитаны
+    bool dueDone(std::uint32_t lastTick) const;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    // Очередь по возрастанию tick: [nextRequest, size) ещё не взяты.
+    // Вектор, а не deque: его ёмкость переживает опустошение очереди.
+    std::vector<Request> requests;
+    std::size_t nextRequest = 0;
+    std::vector<std::uint32_t> runningTicks;  // tick запросов, которые сейчас считаются
+    std::vector<Result> results;
+    bool stopping = false;
+    std::vector<std::thread> threads; // последним: стартуют, когда остальное уже создано
+};
+
+#endif // PATHWORKERS_H
@@ -0,0 +1,65 @@
+#ifndef FORMATION_H
+#define FORMATION_H
+
+#include <cmath>
+#include "point/point.h"
+
+// Построение волны при спавне
+enum class Formation { BLOCK, LINE, COLUMN, WEDGE, CIRCLE };
+
+// Раскладывает count позиций вокруг center с шагом spacing.
+// facing = +1, если отряд смотрит в +x (союзники), -1 — в -x (враги):
+// LINE — шеренга поперёк направления, COLUMN — колонна вдоль него,
+// WEDGE — клин остриём в center.
+inline void layoutFormation(Formation formation, Point center, float spacing,
+                            int count, float facing, Point* out) {
+    switch (formation) {
+    case Formation::LINE: {
+        float origin = -(count - 1) * spacing * 0.5f;
+        for (int i = 0; i < count; ++i) {
+            out[i] = {center.x, center.y + origin + i * spacing};
+        }
+        break;
+    }
+    case Formation::COLUMN: {
+        for (int i = 0; i < count; ++i) {
+            out[i] = {center.x - facing * i * spacing, center.y};
+        }
+        break;
+    }
+    case Formation::WEDGE: {
+        // ряд r содержит 2r+1 юнитов
+        int row = 0, inRow = 0;
+        for (int i = 0; i < count; ++i) {
+            out[i] = {center.x - facing * row * spacing,
+                      center.y + (inRow - row) * spacing};
+            if (++inRow > 2 * row) {
+                ++row;
+                inRow = 0;
+            }
+        }
+        break;
+    }
+    case Formation::CIRCLE: {
+        // радиус такой, чтобы соседи стояли примерно на spacing друг от друга
+        float radius = count > 1 ? count * spacing / (2.0f * float(M_PI)) : 0.0f;
+        for (int i = 0; i < count; ++i) {
+            float angle = 2.0f * float(M_PI) * i / count;
+            out[i] = {center.x + radius * std::cos(angle), center.y + radius * std::sin(angle)};
+        }
+        break;
+    }
+    case Formation::BLOCK:
+    default: {
+        int side = int(std::ceil(std::sqrt(float(count))));
+        float origin = -(side - 1) * spacing * 0.5f;
+        for (int i = 0; i < count; ++i) {
+            out[i] = {center.x + origin + (i % side) * spacing,
+                      center.y + origin + (i / side) * spacing};
+        }
+        break;
+    }
+    }
+}
+
+#endif // FORMATION_H
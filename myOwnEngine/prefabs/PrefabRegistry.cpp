@@ -0,0 +1,95 @@
+#include "PrefabRegistry.h"
+#include <fstream>
+
+namespace {
+
+TeamComponent::Team parseTeam(const nlohmann::json& value) {
+    std::string team = value.get<std::string>();
+    if (team == "ally") return TeamComponent::ALLY;
+    if (team == "enemy") return TeamComponent::ENEMY;
+    throw std::runtime_error("Unknown team: " + team);
+}
+
+Prefab parsePrefab(const nlohmann::json& data, AssetRegistry& assets) {
+    Prefab prefab;
+    prefab.name = data.at("name").get<std::string>();
+    const auto& components = data.at("components");
+
+    if (components.contains("transform")) {
+        const auto& t = components["transform"];
+        prefab.transform = TransformComponent({0, 0}, t.value("rotation", 0.0f), t.value("scale", 1.0f));
+        prefab.signature.insert(typeid(TransformComponent));
+    }
+    if (components.contains("velocity")) {
+        prefab.velocity = VelocityComponent();
+        prefab.signature.insert(typeid(VelocityComponent));
+    }
+    if (components.contains("health")) {
+        prefab.health = HealthComponent(components["health"].at("hp").get<float>());
+        prefab.signature.insert(typeid(HealthComponent));
+    }
+    if (components.contains("team")) {
+        prefab.team = TeamComponent(parseTeam(components["team"]));
+        prefab.signature.insert(typeid(TeamComponent));
+    }
+    if (components.contains("mesh")) {
+        const auto& m = components["mesh"];
+        MeshComponent mesh;
+        mesh.texture = assets.internTexture(m.at("texture").get<std::string>());
+        mesh.mesh = assets.internRectangle(m.at("width").get<float>(), m.at("height").get<float>());
+        prefab.mesh = mesh;
+        prefab.signature.insert(typeid(MeshComponent));
+    }
+    if (components.contains("ai")) {
+        prefab.ai = AIComponent();
+        prefab.signature.insert(typeid(AIComponent));
+    }
+    if (components.contains("combat")) {
+        const auto& c = components["combat"];
+        CombatComponent combat;
+        combat.attackRange = c.at("range").get<float>();
+        combat.damage = c.at("damage").get<int>();
+        combat.attackCooldownTicks = c.value("cooldown", combat.attackCooldownTicks);
+        prefab.combat = combat;
+        prefab.signature.insert(typeid(CombatComponent));
+    }
+    if (components.contains("collidable")) {
+        prefab.collidable = CollidableComponent();
+        prefab.signature.insert(typeid(CollidableComponent));
+    }
+    if (components.contains("path")) {
+        prefab.path = PathComponent();
+        prefab.signature.insert(typeid(PathComponent));
+    }
+    return prefab;
+}
+
+} // namespace
+
+std::size_t PrefabRegistry::load(const nlohmann::json& data, AssetRegistry& assets)
+{
+    std::size_t loaded = 0;
+    for (const auto& entry : data.at("prefabs")) {
+        Prefab prefab = parsePrefab(entry, assets);
+        auto it = ids.find(prefab.name);
+        if (it != ids.end()) {
+            prefabs[it->second] = std::move(prefab);
+        } else {
+            assert(prefabs.size() < INVALID_PREFAB && "Prefab registry is full.");
+            PrefabId id = static_cast<PrefabId>(prefabs.size());
+            ids.emplace(prefab.name, id);
+            prefabs.push_back(std::move(prefab));
+        }
+        ++loaded;
+    }
+    return loaded;
+}
+
+std::size_t PrefabRegistry::loadFromFile(const std::string& path, AssetRegistry& assets)
+{
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open prefab file: " + path);
+    }
+    return load(nlohmann::json::parse(file), assets);
+}
@@ -0,0 +1,60 @@
+#ifndef PREFABREGISTRY_H
+#define PREFABREGISTRY_H
+
+#include <optional>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "components/components.h"
+#include "systems/Systems.h"
+#include "assets/AssetRegistry.h"
+#include "json.hpp"
+
+using PrefabId = std::uint16_t;
+const PrefabId INVALID_PREFAB = UINT16_MAX;
+
+// Шаблон юнита: заранее собранные значения компонентов и их сигнатура.
+// Позиция TransformComponent подставляется при спавне.
+struct Prefab {
+    std::string name;
+    std::optional<TransformComponent> transform;
+    std::optional<VelocityComponent> velocity;
+    std::optional<HealthComponent> health;
+    std::optional<TeamComponent> team;
+    std::optional<MeshComponent> mesh;
+    std::optional<AIComponent> ai;
+    std::optional<CombatComponent> combat;
+    std::optional<CollidableComponent> collidable;
+    std::optional<PathComponent> path;
+
+    Signature signature; // типы всех присутствующих компонентов
+};
+
+// Реестр префабов, загружаемый из JSON вида
+// {"prefabs":[{"name":"soldier","components":{"health":{"hp":100}, ...}}]}
+class PrefabRegistry {
+public:
+    // Возвращает число загруженных префабов; бросает nlohmann::json::exception
+    // на некорректных данных. Префаб с тем же именем перезаписывается.
+    std::size_t load(const nlohmann::json& data, AssetRegistry& assets);
+    std::size_t loadFromFile(const std::string& path, AssetRegistry& assets);
+
+    PrefabId find(const std::string& name) const {
+        auto it = ids.find(name);
+        return it != ids.end() ? it->second : INVALID_PREFAB;
+    }
+
+    const Prefab& get(PrefabId id) const {
+        assert(id < prefabs.size() && "Unknown prefab id.");
+        return prefabs[id];
+    }
+
+    std::size_t size() const { return prefabs.size(); }
+
+private:
+    std::vector<Prefab> prefabs;
+    std::unordered_map<std::string, PrefabId> ids;
+};
+
+#endif // PREFABREGISTRY_H
@@ -0,0 +1,160 @@
+#ifndef BINARYPROTOCOL_H
+#define BINARYPROTOCOL_H
+
+// Компактный бинарный протокол команд для ботов и нагрузочных клиентов.
+// Заголовок не зависит ни от Qt, ни от движка: его копия лежит в CLIclient
+// (как json.hpp), при изменении обновлять обе.
+//
+// Согласование: клиент первым делом шлёт HELLO (8 байт), сервер отвечает
+// своим HELLO с принятой версией. Дальше клиент шлёт CommandRecord по 16 байт,
+// сервер на каждую отвечает ReplyHeader (12 байт) + payloadSize байт данных.
+// Все числа — little-endian.
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+
+namespace binproto {
+
+constexpr std::uint8_t MAGIC[4] = {'E', 'C', 'S', 'B'};
+constexpr std::uint8_t VERSION = 1;
+constexpr std::size_t HELLO_SIZE = 8;   // MAGIC + version + 3 резервных байта
+constexpr std::size_t RECORD_SIZE = 16;
+constexpr std::size_t REPLY_HEADER_SIZE = 12;
+
+// Координаты передаются в 1/64 мировой единицы (диапазон ±512)
+constexpr float QUANT_SCALE = 64.0f;
+
+enum class Op : std::uint8_t {
+    SUMMON = 1,
+    SUMMON_WAVE = 2,
+    MOVE = 3,
+    ABILITY = 4,
+    GET_STATE = 5,
+};
+
+// Индексы совпадают с порядком UNIT_NAMES
+enum class UnitType : std::uint8_t {
+    SOLDIER = 0,
+    ENEMY = 1,
+    FORT = 2,
+    ARCHER = 3,
+    WALL = 4,
+    COUNT
+};
+
+constexpr const char* UNIT_NAMES[] = {"soldier", "enemy", "fort", "archer", "wall"};
+
+enum class Status : std::uint8_t {
+    OK = 0,
+    BAD_RECORD = 1,
+    UNSUPPORTED = 2,
+};
+
+// Команда фиксированного размера:
+// [0..3] sequence, [4] op, [5] unit, [6] formation, [7] резерв,
+// [8..9] x, [10..11] y (квантованные), [12..13] count, [14..15] param
+struct CommandRecord {
+    std::uint32_t sequence = 0;
+    Op op = Op::SUMMON;
+    std::uint8_t unit = 0;
+    std::uint8_t formation = 0; // значение enum Formation движка
+    std::int16_t x = 0;
+    std::int16_t y = 0;
+    std::uint16_t count = 1;
+    std::uint16_t param = 0;    // шаг построения в 1/64 (SUMMON_WAVE), id сущности (MOVE/ABILITY)
+};
+
+// Ответ сервера: [0..3] sequence команды, [4] op, [5] status, [6..7] резерв,
+// [8..11] размер данных (JSON состояния для GET_STATE, иначе 0)
+struct ReplyHeader {
+    std::uint32_t sequence = 0;
+    Op op = Op::SUMMON;
+    Status status = Status::OK;
+    std::uint32_t payloadSize = 0;
+};
+
+inline std::int16_t quantize(float value) {
+    float q = std::round(value * QUANT_SCALE);
+    return static_cast<std::int16_t>(std::clamp(q, -32768.0f, 32767.0f));
+}
+
+inline float dequantize(std::int16_t value) {
+    return value / QUANT_SCALE;
+}
+
+inline void writeU16(std::uint8_t* out, std::uint16_t v) {
+    out[0] = std::uint8_t(v);
+    out[1] = std::uint8_t(v >> 8);
+}
+
+inline void writeU32(std::uint8_t* out, std::uint32_t v) {
+    for (int i = 0; i < 4; ++i) out[i] = std::uint8_t(v >> (8 * i));
+}
+
+inline std::uint16_t readU16(const std::uint8_t* in) {
+    return std::uint16_t(in[0] | (in[1] << 8));
+}
+
+inline std::uint32_t readU32(const std::uint8_t* in) {
+    return std::uint32_t(in[0]) | (std::uint32_t(in[1]) << 8) |
+           (std::uint32_t(in[2]) << 16) | (std::uint32_t(in[3]) << 24);
+}
+
+inline void writeHello(std::uint8_t* out, std::uint8_t version = VERSION) {
+    std::copy(MAGIC, MAGIC + 4, out);
+    out[4] = version;
+    out[5] = out[6] = out[7] = 0;
+}
+
+// Возвращает версию из HELLO или 0, если это не HELLO
+inline std::uint8_t readHello(const std::uint8_t* in) {
+    return std::equal(MAGIC, MAGIC + 4, in) ? in[4] : 0;
+}
+
+inline void encode(const CommandRecord& r, std::uint8_t* out) {
+    writeU32(out, r.sequence);
+    out[4] = std::uint8_t(r.op);
+    out[5] = r.unit;
+    out[6] = r.formation;
+    out[7] = 0;
+    writeU16(out + 8, std::uint16_t(r.x));
+    writeU16(out + 10, std::uint16_t(r.y));
+    writeU16(out + 12, r.count);
+    writeU16(out + 14, r.param);
+}
+
+inline CommandRecord decodeRecord(const std::uint8_t* in) {
+    CommandRecord r;
+    r.sequence = readU32(in);
+    r.op = Op(in[4]);
+    r.unit = in[5];
+    r.formation = in[6];
+    r.x = std::int16_t(readU16(in + 8));
+    r.y = std::int16_t(readU16(in + 10));
+    r.count = readU16(in + 12);
+    r.param = readU16(in + 14);
+    return r;
+}
+
+inline void encode(const ReplyHeader& h, std::uint8_t* out) {
+    writeU32(out, h.sequence);
+    out[4] = std::uint8_t(h.op);
+    out[5] = std::uint8_t(h.status);
+    out[6] = out[7] = 0;
+    writeU32(out + 8, h.payloadSize);
+}
+
+inline ReplyHeader decodeReply(const std::uint8_t* in) {
+    ReplyHeader h;
+    h.sequence = readU32(in);
+    h.op = Op(in[4]);
+    h.status = Status(in[5]);
+    h.payloadSize = readU32(in + 8);
+    return h;
+}
+
+} // namespace binproto
+
+#endif // BINARYPROTOCOL_H
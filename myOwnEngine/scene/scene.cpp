@@ -2,35 +2,113 @@
 #include "Scene.h"
 #include <algorithm>
 #include <limits>
+#include <cmath>
 #include "meshUtils.h"
 
 
 void Scene::update() {
+    // Камера следует за выбранной сущностью, пока та жива
+    if (entityManager.isAlive(cameraFocusEntity) &&
+        componentManager.hasComponent<TransformComponent>(cameraFocusEntity)) {
+        camera.setPosition(componentManager.getComponent<TransformComponent>(cameraFocusEntity).position);
+    }
+    visibilitySystem->update(camera, getSpatialGrid());
+
+    auto flowFieldSystem = systemManager.getSystem<FlowFieldSystem>();
+    flowFieldSystem->update(componentManager, assets, tickCount);
+
+    auto pathfindingSystem = systemManager.getSystem<PathfindingSystem>();
+    pathfindingSystem->update(componentManager, assets, flowFieldSystem->entities, tickCount);
+
     auto aiSystem = systemManager.getSystem<AISystem>();
-    aiSystem->update(componentManager, systemManager, entityManager, eventBus);
+    aiSystem->update(componentManager, assets, systemManager, entityManager, eventBus,
+                     *visibilitySystem, *flowFieldSystem, activity, tickCount);
+
+    auto separationSystem = systemManager.getSystem<SeparationSystem>();
+    separationSystem->update(componentManager, getSpatialGrid(), activity);
 
     auto movementSystem = systemManager.getSystem<MovementSystem>();
-    movementSystem->update(componentManager);
+    movementSystem->update(componentManager, activity);
 
     auto collisionSystem = systemManager.getSystem<CollisionSystem>();
-    collisionSystem->update(componentManager);
+    collisionSystem->update(componentManager, assets, *visibilitySystem, activity, tickCount);
 
     auto winConditionSystem = systemManager.getSystem<WinConditionSystem>();
     winConditionSystem->update(componentManager);
+
+    // события тика раздаются пачками, затем применяются отложенные изменения
+    eventBus.dispatchQueued();
+    flushCommands();
+
+    activity.flush();
+    frameArena.reset();
+    spatialGridDirty = true;
+    ++tickCount;
+}
+
+void Scene::flushCommands()
+{
+    // Команды, записанные во время применения, попадут в следующий проход
+    while (!commandBuffer.empty()) {
+        commandBuffer.swap(pendingCommands);
+        for (auto& command : pendingCommands) {
+            // повторная смерть / изменения уже удалённой сущности игнорируются
+            if (!entityManager.isAlive(command.entity)) continue;
+
+            if (command.type == CommandBuffer::CommandType::DESTROY) {
+                destroyEntity(command.entity);
+            } else {
+                command.apply(componentManager);
+                updateSystemSubscriptions(command.entity);
+                activity.wake(command.entity);
+                spatialGridDirty = true;
+            }
+        }
+        pendingCommands.clear();
+    }
+    commandBuffer.recycle();
 }
 
 void Scene::destroyEntity(Entity entity)
 {
     componentManager.removeAllComponents(entity);
     systemManager.removeEntityFromAllSystems(entity);
+    activity.remove(entity);
     entityManager.destroyEntity(entity);
+    spatialGridDirty = true;
+}
+
+bool Scene::isVisible(Entity entity) const
+{
+    return visibilitySystem->isVisible(entity);
+}
+
+const SpatialGrid& Scene::getSpatialGrid() const
+{
+    if (!spatialGridDirty) return spatialGrid;
+
+    spatialGrid.clear();
+    for (Entity entity : entityManager.getAliveEntities()) {
+        if (!componentManager.hasComponent<TransformComponent>(entity)) continue;
+        const Point& position = componentManager.getComponent<TransformComponent>(entity).position;
+        WorldRect bounds{position.x, position.y, position.x, position.y};
+        if (componentManager.hasComponent<MeshComponent>(entity)) {
+            const auto& mesh = assets.meshBounds(componentManager.getComponent<MeshComponent>(entity).mesh);
+            bounds = {position.x + mesh.minX, position.y + mesh.minY,
+                      position.x + mesh.maxX, position.y + mesh.maxY};
+        }
+        spatialGrid.insert(entity, bounds);
+    }
+    spatialGrid.build();
+    spatialGridDirty = false;
+    return spatialGrid;
 }
 
 
 void Scene::updateSystemSubscriptions(Entity entity)
 {
     for (auto& [type, system] : systemManager.getSystems()) {
-        auto signature = systemManager.getSystemSignature(type);
+        const auto& signature = systemManager.getSystemSignature(type);
         bool matches = true;
 
         for (auto& componentType : signature) {
@@ -49,20 +127,92 @@ void Scene::updateSystemSubscriptions(Entity entity)
 }
 
 
+int Scene::spawnBatch(PrefabId prefabId, Point center, int count, Formation formation, float spacing)
+{
+    const Prefab& prefab = prefabs.get(prefabId);
+    count = std::min<int>(count, int(entityManager.getAvailableCount()));
+    if (count <= 0) return 0;
+
+    std::pmr::memory_resource* arena = frameArena.resource();
+
+    // Системы, в сигнатуру которых укладывается префаб, — один раз на пачку
+    std::pmr::vector<System*> matchingSystems(arena);
+    for (auto& [type, system] : systemManager.getSystems()) {
+        const auto& signature = systemManager.getSystemSignature(type);
+        if (std::includes(prefab.signature.begin(), prefab.signature.end(),
+                          signature.begin(), signature.end())) {
+            matchingSystems.push_back(system.get());
+        }
+    }
+
+    std::pmr::vector<Entity> batch(count, arena);
+    entityManager.createEntities(batch.size(), batch.data());
+
+    if (prefab.transform) {
+        if (spacing <= 0.0f) {
+            spacing = 1.0f;
+            if (prefab.mesh) {
+                const auto& bounds = assets.meshBounds(prefab.mesh->mesh);
+                spacing = std::max(bounds.width(), bounds.height()) * 1.1f;
+            }
+        }
+        float facing = prefab.team && prefab.team->team == TeamComponent::ENEMY ? -1.0f : 1.0f;
+        std::pmr::vector<Point> positions(count, arena);
+        layoutFormation(formation, center, spacing, count, facing, positions.data());
+
+        componentManager.addComponents<TransformComponent>(batch.data(), batch.size(), *prefab.transform);
+        for (int i = 0; i < count; ++i) {
+            componentManager.getComponent<TransformComponent>(batch[i]).position = positions[i];
+        }
+    }
+    if (prefab.velocity) componentManager.addComponents(batch.data(), batch.size(), *prefab.velocity);
+    if (prefab.health) componentManager.addComponents(batch.data(), batch.size(), *prefab.health);
+    if (prefab.team) componentManager.addComponents(batch.data(), batch.size(), *prefab.team);
+    if (prefab.mesh) componentManager.addComponents(batch.data(), batch.size(), *prefab.mesh);
+    if (prefab.ai) componentManager.addComponents(batch.data(), batch.size(), *prefab.ai);
+    if (prefab.combat) componentManager.addComponents(batch.data(), batch.size(), *prefab.combat);
+    if (prefab.collidable) componentManager.addComponents(batch.data(), batch.size(), *prefab.collidable);
+    if (prefab.path) componentManager.addComponents(batch.data(), batch.size(), *prefab.path);
+
+    for (System* system : matchingSystems) {
+        system->entities.append(batch.data(), batch.size());
+    }
+    activity.wake(batch.data(), batch.size());
+    spatialGridDirty = true;
+    return count;
+}
+
+
 template<typename T>
 void Scene::removeComponent(Entity entity)
 {
 
     componentManager.removeComponent<T>(entity);
     updateSystemSubscriptions(entity);
+    activity.wake(entity);
+    spatialGridDirty = true;
 }
 
 
-Scene::Scene() {
+Scene::Scene()
+    : commandBuffer(entityManager)
+{
+    componentManager.setTransientResource(frameArena.resource());
+    // Команд за тик обычно не больше, чем сущностей (волна смертей);
+    // запас сразу, чтобы бой не перевыделял очередь по ходу
+    pendingCommands.reserve(MAX_ENTITIES);
+    // Урон и смерти — не больше события на сущность за тик
+    eventBus.channel<HealthChangedEvent>().reserve(MAX_ENTITIES);
+    eventBus.channel<EntityDiedEvent>().reserve(MAX_ENTITIES);
+
     auto movementSystem = systemManager.registerSystem<MovementSystem>();
     auto collisionSystem = systemManager.registerSystem<CollisionSystem>();
     auto aiSystem = systemManager.registerSystem<AISystem>();
     auto winConditionSystem = systemManager.registerSystem<WinConditionSystem>();
+    visibilitySystem = systemManager.registerSystem<VisibilitySystem>();
+    auto flowFieldSystem = systemManager.registerSystem<FlowFieldSystem>();
+    auto pathfindingSystem = systemManager.registerSystem<PathfindingSystem>();
+    auto separationSystem = systemManager.registerSystem<SeparationSystem>();
 
     // AISystem требует Transform + Velocity + AIComponent
     Signature aiSignature;
@@ -84,10 +234,33 @@ Scene::Scene() {
     collisionSignature.insert(typeid(CollidableComponent));
     systemManager.setSystemSignature<CollisionSystem>(collisionSignature);
 
+    // SeparationSystem — подвижные юниты, которые сталкиваются
+    Signature separationSignature;
+    separationSignature.insert(typeid(TransformComponent));
+    separationSignature.insert(typeid(VelocityComponent));
+    separationSignature.insert(typeid(CollidableComponent));
+    systemManager.setSystemSignature<SeparationSystem>(separationSignature);
+
+    // VisibilitySystem — всё, у чего есть положение
+    Signature visibilitySignature;
+    visibilitySignature.insert(typeid(TransformComponent));
+    systemManager.setSystemSignature<VisibilitySystem>(visibilitySignature);
+
+    // FlowFieldSystem — препятствия берутся из тех же Transform + Mesh + Collidable
+    // (подвижные отсеиваются при построении карты)
+    systemManager.setSystemSignature<FlowFieldSystem>(collisionSignature);
+
+    // PathfindingSystem — юниты со своим маршрутом
+    Signature pathSignature;
+    pathSignature.insert(typeid(TransformComponent));
+    pathSignature.insert(typeid(PathComponent));
+    systemManager.setSystemSignature<PathfindingSystem>(pathSignature);
+
     Signature winConditionSignature;
     systemManager.setSystemSignature<WinConditionSystem>(winConditionSignature);
 
-    deathSystem = std::make_unique<DeathSystem>(eventBus, componentManager, systemManager, entityManager);
+    aiSystem->connect(eventBus);
+    deathSystem = std::make_unique<DeathSystem>(eventBus, commandBuffer);
     healthChangeSystem = std::make_unique<HealthChangeSystem>(eventBus);
 
 }
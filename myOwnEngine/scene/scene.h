@@ -9,6 +9,12 @@
 #include "components/components.h"
 #include "entity/Entity.h"
 #include "EventBus.h"
+#include "CommandBuffer.h"
+#include "memory/FrameArena.h"
+#include "assets/AssetRegistry.h"
+#include "prefabs/PrefabRegistry.h"
+#include "prefabs/Formation.h"
+#include "spatial/SpatialGrid.h"
 
 class Scene {
 
@@ -16,8 +22,17 @@ private:
     EntityManager entityManager;
     ComponentManager componentManager;
     SystemManager systemManager;
+    // отложенные структурные изменения, применяются в flushCommands()
+    CommandBuffer commandBuffer;
+    std::vector<CommandBuffer::Command> pendingCommands;
+    // временная память тика, сбрасывается в конце update()
+    FrameArena frameArena;
 
     Camera2D camera;
+    // номер тика: по нему системы разносят редкую работу по разным тикам
+    std::uint32_t tickCount = 0;
+    AssetRegistry assets;
+    PrefabRegistry prefabs;
 
     Entity controllableEntity = MAX_ENTITIES + 1;
     Entity cameraFocusEntity = MAX_ENTITIES + 1;
@@ -26,11 +41,29 @@ private:
     // реактивные (event) системы
     std::unique_ptr<HealthChangeSystem> healthChangeSystem;
     std::unique_ptr<DeathSystem> deathSystem;
+    // кадр камеры нужен и вне update() (isVisible)
+    std::shared_ptr<VisibilitySystem> visibilitySystem;
+
+    // Кто двигается; спящие не обходятся движением и столкновениями
+    ActivitySet activity;
+
+    // Где какие сущности: строится по запросу, если сцена менялась
+    mutable SpatialGrid spatialGrid;
+    mutable bool spatialGridDirty = true;
 public:
     Scene();
     EventBus& getEventBus() { return eventBus; }
+    CommandBuffer& getCommandBuffer() { return commandBuffer; }
+    AssetRegistry& getAssets() { return assets; }
+    const AssetRegistry& getAssets() const { return assets; }
+    PrefabRegistry& getPrefabs() { return prefabs; }
+    const PrefabRegistry& getPrefabs() const { return prefabs; }
+    // Память для временных данных между тиками (например, сериализации);
+    // действительна до следующего update()
+    std::pmr::memory_resource* getFrameResource() { return frameArena.resource(); }
     Entity createEntity(bool isControllable, bool isCameraFocus) {
         Entity entity = entityManager.createEntity();
+        spatialGridDirty = true;
         if (isControllable) {
             controllableEntity = entity;
         }
@@ -41,11 +74,24 @@ public:
     }
     void destroyEntity(Entity entity);
 
+    // Создаёт волну из count сущностей по префабу в заданном построении:
+    // id резервируются разом, компоненты пишутся в массивы подряд,
+    // списки подходящих систем пополняются за один проход.
+    // spacing <= 0 — шаг по размеру меша.
+    // Возвращает число созданных сущностей (меньше count, если кончились id).
+    int spawnBatch(PrefabId prefabId, Point center, int count,
+                   Formation formation = Formation::BLOCK, float spacing = 0.0f);
+    int spawn(PrefabId prefabId, Point position, int count = 1) {
+        return spawnBatch(prefabId, position, count);
+    }
+
     template<typename T, typename... Args>
     T& addComponent(Entity entity, Args&&... args) {
         T component(std::forward<Args>(args)...);
         componentManager.addComponent<T>(entity, component);
         updateSystemSubscriptions(entity);
+        activity.wake(entity);
+        spatialGridDirty = true;
         return componentManager.getComponent<T>(entity);
     }
     const std::set<Entity>& getAllEntities() const {
@@ -61,8 +107,20 @@ public:
     bool hasComponent(Entity entity) const { return componentManager.hasComponent<T>(entity); }
 
     void update();
+    // Точка синхронизации: применяет всё, что записано в commandBuffer
+    void flushCommands();
     bool isEmptyScene();
+
+    // Сетка по границам мешей (без меша — точка в центре) для выборки
+    // сущностей в прямоугольнике; действительна до следующего изменения сцены
+    const SpatialGrid& getSpatialGrid() const;
     Camera2D& getCamera() { return camera; }
+    const Camera2D& getCamera() const { return camera; }
+    // Как часто юниты ищут цель (см. AISchedule)
+    void setAISchedule(const AISchedule& schedule) { systemManager.getSystem<AISystem>()->setSchedule(schedule); }
+    const AISchedule& getAISchedule() { return systemManager.getSystem<AISystem>()->getSchedule(); }
+    // Попала ли сущность в кадр камеры на последнем тике
+    bool isVisible(Entity entity) const;
 
     Entity getFocusEntity() { return cameraFocusEntity; }
     Entity getControllableEntity() { return controllableEntity; }
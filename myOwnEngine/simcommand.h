@@ -0,0 +1,25 @@
+#ifndef SIMCOMMAND_H
+#define SIMCOMMAND_H
+
+#include <cstdint>
+#include "prefabs/PrefabRegistry.h"
+#include "prefabs/Formation.h"
+
+enum class CommandAction : std::uint8_t {
+    SUMMON,
+    SUMMON_WAVE,
+};
+
+// Уже проверенная команда в компактном виде: строк и JSON здесь нет,
+// симуляция применяет её как есть
+struct SimCommand {
+    CommandAction action;
+    Formation formation;
+    PrefabId unit;
+    std::uint16_t count;
+    float x;
+    float y;
+    float spacing; // <= 0 — шаг по размеру меша
+};
+
+#endif // SIMCOMMAND_H
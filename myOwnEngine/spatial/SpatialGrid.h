@@ -0,0 +1,160 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include "entity/Entity.h"
+
+// Прямоугольник в мировых координатах (y растёт вверх)
+struct WorldRect {
+    float minX, minY, maxX, maxY;
+
+    bool intersects(const WorldRect& other) const {
+        return minX <= other.maxX && other.minX <= maxX &&
+               minY <= other.maxY && other.minY <= maxY;
+    }
+};
+
+// Равномерная сетка по центрам сущностей для запросов "кто в прямоугольнике".
+// Перестраивается целиком (сортировка подсчётом по ячейкам): на тысячах
+// движущихся сущностей это дешевле, чем поддерживать её при каждом сдвиге.
+// Сетка накрывает только занятую область и не больше MAX_CELLS ячеек:
+// при сильном разлёте ячейки укрупняются, а не растёт память.
+class SpatialGrid {
+public:
+    struct Item {
+        Entity entity;
+        WorldRect bounds;
+    };
+
+    static constexpr int MAX_CELLS = 64 * 64;
+
+    explicit SpatialGrid(float cellSize = 2.0f) : baseCellSize(cellSize) {}
+
+    // Заполнение: clear(), insert() для каждой сущности, build()
+    void clear() {
+        pending.clear();
+        items.clear();
+        cellStart.assign(1, 0);
+        columns = rows = 0;
+        maxHalfWidth = maxHalfHeight = 0.0f;
+    }
+
+    void insert(Entity entity, const WorldRect& bounds) {
+        pending.push_back({entity, bounds});
+    }
+
+    void build() {
+        if (pending.empty()) {
+            items.clear();
+            cellStart.assign(1, 0);
+            columns = rows = 0;
+            return;
+        }
+
+        // сущности с NaN/бесконечными координатами в размер сетки не входят
+        float minX = INFINITY, maxX = -INFINITY;
+        float minY = INFINITY, maxY = -INFINITY;
+        maxHalfWidth = maxHalfHeight = 0.0f;
+        for (const Item& item : pending) {
+            if (std::isfinite(centerX(item)) && std::isfinite(centerY(item))) {
+                minX = std::min(minX, centerX(item));
+                maxX = std::max(maxX, centerX(item));
+                minY = std::min(minY, centerY(item));
+                maxY = std::max(maxY, centerY(item));
+            }
+            maxHalfWidth = std::max(maxHalfWidth, (item.bounds.maxX - item.bounds.minX) / 2);
+            maxHalfHeight = std::max(maxHalfHeight, (item.bounds.maxY - item.bounds.minY) / 2);
+        }
+        if (minX > maxX) {
+            minX = maxX = minY = maxY = 0.0f;
+        }
+        originX = minX;
+        originY = minY;
+        cellSize = baseCellSize;
+        while (cellCount(maxX - minX, cellSize) * cellCount(maxY - minY, cellSize) > MAX_CELLS) {
+            cellSize *= 2;
+        }
+        columns = cellCount(maxX - minX, cellSize);
+        rows = cellCount(maxY - minY, cellSize);
+
+        // Подсчёт по ячейкам, префиксные суммы, раскладка
+        cellStart.assign(std::size_t(columns * rows) + 1, 0);
+        cellOf.resize(pending.size());
+        for (std::size_t i = 0; i < pending.size(); ++i) {
+            cellOf[i] = cellIndex(centerX(pending[i]), centerY(pending[i]));
+            ++cellStart[cellOf[i] + 1];
+        }
+        for (std::size_t c = 1; c < cellStart.size(); ++c) {
+            cellStart[c] += cellStart[c - 1];
+        }
+        items.resize(pending.size());
+        cursor.assign(cellStart.begin(), cellStart.end() - 1);
+        for (std::size_t i = 0; i < pending.size(); ++i) {
+            items[cursor[cellOf[i]]++] = pending[i];
+        }
+        pending.clear();
+    }
+
+    // Вызывает fn(const Item&) для каждой сущности, чьи границы пересекают rect
+    template<typename Fn>
+    void query(const WorldRect& rect, Fn&& fn) const {
+        if (items.empty()) return;
+        // центр задевающей rect сущности может лежать за его краем на полразмера
+        int x0 = column(rect.minX - maxHalfWidth);
+        int x1 = column(rect.maxX + maxHalfWidth);
+        int y0 = row(rect.minY - maxHalfHeight);
+        int y1 = row(rect.maxY + maxHalfHeight);
+        for (int y = y0; y <= y1; ++y) {
+            // ячейки одной строки лежат подряд
+            std::uint32_t begin = cellStart[std::size_t(y * columns + x0)];
+            std::uint32_t end = cellStart[std::size_t(y * columns + x1) + 1];
+            for (std::uint32_t i = begin; i < end; ++i) {
+                if (items[i].bounds.intersects(rect)) fn(items[i]);
+            }
+        }
+    }
+
+    std::size_t size() const { return items.size(); }
+
+private:
+    static float centerX(const Item& item) { return (item.bounds.minX + item.bounds.maxX) / 2; }
+    static float centerY(const Item& item) { return (item.bounds.minY + item.bounds.maxY) / 2; }
+
+    static int cellCount(float extent, float size) {
+        float n = std::floor(extent / size) + 1.0f;
+        return n < float(MAX_CELLS) ? int(n) : MAX_CELLS + 1;
+    }
+
+    // Координаты вне сетки (и NaN) прижимаются к краевым ячейкам
+    static int clampCell(float cell, int count) {
+        if (!(cell >= 0.0f)) return 0;
+        if (cell >= float(count - 1)) return count - 1;
+        return int(cell);
+    }
+    int column(float x) const { return clampCell(std::floor((x - originX) / cellSize), columns); }
+    int row(float y) const { return clampCell(std::floor((y - originY) / cellSize), rows); }
+    std::uint32_t cellIndex(float x, float y) const {
+        return std::uint32_t(row(y) * columns + column(x));
+    }
+
+    float baseCellSize;
+    float cellSize = 0.0f;
+    float originX = 0.0f;
+    float originY = 0.0f;
+    int columns = 0;
+    int rows = 0;
+    float maxHalfWidth = 0.0f;
+    float maxHalfHeight = 0.0f;
+
+    std::vector<Item> pending;
+    std::vector<Item> items;              // отсортированы по ячейкам
+    std::vector<std::uint32_t> cellStart; // items[cellStart[c] .. cellStart[c + 1])
+    std::vector<std::uint32_t> cellOf;
+    std::vector<std::uint32_t> cursor;
+};
+
+#endif // SPATIALGRID_H
@@ -0,0 +1,229 @@
+#include "stateserializer.h"
+#include <charconv>
+#include <cmath>
+
+namespace {
+
+void appendNumber(std::pmr::string& out, float value) {
+    if (!std::isfinite(value)) {
+        out += "null"; // как у nlohmann::json
+        return;
+    }
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+void appendNumber(std::pmr::string& out, Entity value) {
+    char buffer[16];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+void appendString(std::pmr::string& out, const std::string& value) {
+    out += '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            static const char hex[] = "0123456789abcdef";
+            out += "\\u00";
+            out += hex[(c >> 4) & 0xF];
+            out += hex[c & 0xF];
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+// Текущее состояние сущности в том виде, в каком его видит клиент
+struct EntityView {
+    const std::string* texture;
+    float width;
+    float height;
+    float hp;
+    MeshId mesh;
+    TextureId textureId;
+    bool hasMesh;
+};
+
+EntityView viewEntity(const Scene& scene, Entity entity) {
+    static const std::string defaultTexture = "default.png";
+
+    // Могут быть дефолтные значения
+    EntityView view{&defaultTexture, 0.5f, 0.5f, 0.0f, 0, 0, false};
+    if (scene.hasComponent<MeshComponent>(entity)) {
+        const auto& mesh = scene.getComponent<MeshComponent>(entity);
+        const auto& bounds = scene.getAssets().meshBounds(mesh.mesh);
+        view.texture = &scene.getAssets().textureName(mesh.texture);
+        view.width = bounds.width();
+        view.height = bounds.height();
+        view.mesh = mesh.mesh;
+        view.textureId = mesh.texture;
+        view.hasMesh = true;
+    }
+    if (scene.hasComponent<HealthComponent>(entity)) {
+        view.hp = scene.getComponent<HealthComponent>(entity).health;
+    }
+    return view;
+}
+
+void appendEntity(std::pmr::string& out, Entity entity, const Point& position, const EntityView& view) {
+    static const std::string defaultType = "soldier"; // Можешь расширить если есть другие типы
+
+    out += "{\"id\":";
+    appendNumber(out, entity);
+    out += ",\"type\":";
+    appendString(out, defaultType);
+    out += ",\"x\":";
+    appendNumber(out, position.x);
+    out += ",\"y\":";
+    appendNumber(out, position.y);
+    out += ",\"hp\":";
+    appendNumber(out, view.hp);
+    out += ",\"texture\":";
+    appendString(out, *view.texture);
+    out += ",\"width\":";
+    appendNumber(out, view.width);
+    out += ",\"height\":";
+    appendNumber(out, view.height);
+    out += '}';
+}
+
+} // namespace
+
+std::pmr::string serializeScene(const Scene& scene, std::pmr::memory_resource* resource)
+{
+    std::pmr::string out(resource);
+    serializeScene(scene, out);
+    return out;
+}
+
+void serializeScene(const Scene& scene, std::pmr::string& out)
+{
+    out.clear();
+    // ~128 байт на сущность, чтобы строка не перевыделялась по ходу
+    out.reserve(32 + scene.getAllEntities().size() * 128);
+
+    out += "{\"entities\":[";
+    bool first = true;
+    for (const auto& entity : scene.getAllEntities()) {
+        if (!scene.hasComponent<TransformComponent>(entity)) continue;
+        const auto& transform = scene.getComponent<TransformComponent>(entity);
+
+        if (!first) out += ',';
+        first = false;
+        appendEntity(out, entity, transform.position, viewEntity(scene, entity));
+    }
+    out += "]}";
+}
+
+std::pmr::string serializeScene(const Scene& scene, const WorldRect& view,
+                                std::pmr::memory_resource* resource)
+{
+    std::pmr::string out(resource);
+    serializeScene(scene, view, out);
+    return out;
+}
+
+void serializeScene(const Scene& scene, const WorldRect& view, std::pmr::string& out)
+{
+    out.clear();
+    out += "{\"entities\":[";
+    bool first = true;
+    scene.getSpatialGrid().query(view, [&](const SpatialGrid::Item& item) {
+        const auto& transform = scene.getComponent<TransformComponent>(item.entity);
+        if (!first) out += ',';
+        first = false;
+        appendEntity(out, item.entity, transform.position, viewEntity(scene, item.entity));
+    });
+    out += "]}";
+}
+
+StateDeltaTracker::StateDeltaTracker()
+    : sent(MAX_ENTITIES)
+{
+    known.reserve(MAX_ENTITIES);
+}
+
+std::pmr::string StateDeltaTracker::serializeDelta(const Scene& scene, std::pmr::memory_resource* resource)
+{
+    std::pmr::string out(resource);
+    serializeDelta(scene, out);
+    return out;
+}
+
+void StateDeltaTracker::serializeDelta(const Scene& scene, std::pmr::string& out)
+{
+    out.clear();
+    out += "{\"delta\":";
+    appendNumber(out, Entity(sequence));
+    bool changed = false;
+
+    // Исчезнувшие: были у клиента, а Transform больше нет (сущность уничтожена)
+    out += ",\"remove\":[";
+    bool first = true;
+    for (std::size_t i = 0; i < known.size();) {
+        Entity entity = known[i];
+        if (scene.hasComponent<TransformComponent>(entity)) {
+            ++i;
+            continue;
+        }
+        sent[entity].known = false;
+        known[i] = known.back();
+        known.pop_back();
+
+        if (!first) out += ',';
+        first = false;
+        appendNumber(out, entity);
+        changed = true;
+    }
+
+    out += "],\"upsert\":[";
+    first = true;
+    for (const auto& entity : scene.getAllEntities()) {
+        if (!scene.hasComponent<TransformComponent>(entity)) continue;
+        const Point& position = scene.getComponent<TransformComponent>(entity).position;
+        EntityView view = viewEntity(scene, entity);
+        SentEntity& last = sent[entity];
+
+        bool full = !last.known || last.hasMesh != view.hasMesh
+                    || last.mesh != view.mesh || last.texture != view.textureId;
+        bool moved = position.x != last.x || position.y != last.y;
+        bool hurt = view.hp != last.hp;
+        if (!full && !moved && !hurt) continue;
+
+        if (!first) out += ',';
+        first = false;
+        if (full) {
+            appendEntity(out, entity, position, view);
+            if (!last.known) known.push_back(entity);
+        } else {
+            out += "{\"id\":";
+            appendNumber(out, entity);
+            if (moved) {
+                out += ",\"x\":";
+                appendNumber(out, position.x);
+                out += ",\"y\":";
+                appendNumber(out, position.y);
+            }
+            if (hurt) {
+                out += ",\"hp\":";
+                appendNumber(out, view.hp);
+            }
+            out += '}';
+        }
+        last = {true, position.x, position.y, view.hp, view.mesh, view.textureId, view.hasMesh};
+        changed = true;
+    }
+    out += "]}";
+
+    // Первое сообщение уходит всегда, даже для пустой сцены
+    if (!changed && sequence > 0) {
+        out.clear();
+        return;
+    }
+    ++sequence;
+}
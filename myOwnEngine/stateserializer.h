@@ -0,0 +1,54 @@
+#ifndef STATESERIALIZER_H
+#define STATESERIALIZER_H
+
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "scene/scene.h"
+
+// Сериализует состояние сцены в JSON вида {"entities":[...]} сразу в строку,
+// без промежуточного nlohmann::json. Строка берёт память из resource
+// (обычно арена тика сцены) и должна быть освобождена до следующего update().
+std::pmr::string serializeScene(const Scene& scene, std::pmr::memory_resource* resource);
+// То же в готовую строку: прежнее содержимое стирается, ёмкость остаётся.
+// Так пишет сервер — в буфер сессии, а не в арену: запросы клиента
+// не привязаны к тикам, и арена росла бы от их числа.
+void serializeScene(const Scene& scene, std::pmr::string& out);
+
+// То же, но только сущности, чьи границы задевают view (то, что видит клиент).
+// Выборка идёт через сетку сцены: стоимость растёт с числом видимых, а не всех.
+std::pmr::string serializeScene(const Scene& scene, const WorldRect& view,
+                                std::pmr::memory_resource* resource);
+void serializeScene(const Scene& scene, const WorldRect& view, std::pmr::string& out);
+
+// То, что уже отправлено одному клиенту-подписчику; по нему считается дельта:
+// только появившиеся, изменившиеся и исчезнувшие сущности.
+class StateDeltaTracker {
+public:
+    StateDeltaTracker();
+
+    // {"delta":N,"remove":[id,...],"upsert":[{...},...]}. Новые сущности и
+    // сменившие меш (id переиспользован) идут полной записью, остальные —
+    // только id и изменившимися полями. Пустая строка — изменений не было.
+    // Первый вызов отдаёт всю сцену.
+    std::pmr::string serializeDelta(const Scene& scene, std::pmr::memory_resource* resource);
+    void serializeDelta(const Scene& scene, std::pmr::string& out);
+
+private:
+    struct SentEntity {
+        bool known = false;
+        float x = 0.0f;
+        float y = 0.0f;
+        float hp = 0.0f;
+        MeshId mesh = 0;
+        TextureId texture = 0;
+        bool hasMesh = false;
+    };
+
+    std::vector<SentEntity> sent; // индекс — Entity
+    std::vector<Entity> known;    // сущности, которые есть у клиента
+    std::uint32_t sequence = 0;
+};
+
+#endif // STATESERIALIZER_H
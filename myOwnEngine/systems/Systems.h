@@ -8,17 +8,27 @@
 #include <typeindex>
 #include <cassert>
 #include <cmath>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
 #include "entity/Entity.h"
 #include "entity/EntityManager.h"
+#include "entity/EntitySet.h"
+#include "entity/ActivitySet.h"
 #include "components/Components.h"
 #include "components/ComponentManager.h"
 #include "camera/camera2d.h"
+#include "spatial/SpatialGrid.h"
+#include "navigation/FlowField.h"
+#include "navigation/HierarchicalPathfinder.h"
+#include "navigation/PathWorkers.h"
 #include "EventBus.h"
+#include "CommandBuffer.h"
 
 
 class System {
 public:
-    std::set<Entity> entities;
+    EntitySet entities;
 };
 
 using Signature = std::set<std::type_index>;
@@ -36,9 +46,8 @@ public:
     }
 
     template<typename T>
-    Signature getSystemSignature() {
-        std::type_index typeName(typeid(T));
-        return systemSignatures[typeName];
+    const Signature& getSystemSignature() const {
+        return getSystemSignature(std::type_index(typeid(T)));
     }
     const Signature& getSystemSignature(const std::type_index& type) const {
         auto it = systemSignatures.find(type);
@@ -89,12 +98,65 @@ public:
     }
 };
 
+// Кто в кадре камеры на этом тике. Сущности вне кадра симулируются грубее
+// (реже ищут цель, реже проверяют столкновения), в кадре — как раньше.
+// Ненастроенная камера (zoom <= 0) видит всё.
+class VisibilitySystem : public System {
+public:
+    // Запас вокруг кадра, чтобы подходящие к краю юниты уже были "в кадре"
+    static constexpr float VISIBILITY_MARGIN = 1.0f;
+
+    VisibilitySystem() : visible(MAX_ENTITIES, 1) {}
+
+    void update(const Camera2D& camera, const SpatialGrid& grid) {
+        if (!camera.isBounded()) {
+            // без границ всё видно, пока камеру не настроят: заполнить один раз
+            if (!allVisible) {
+                std::fill(visible.begin(), visible.end(), 1);
+                allVisible = true;
+            }
+            visibleCount = entities.size();
+            return;
+        }
+        allVisible = false;
+        std::fill(visible.begin(), visible.end(), 0);
+        visibleCount = 0;
+        grid.query(camera.viewRect(VISIBILITY_MARGIN), [this](const SpatialGrid::Item& item) {
+            visible[item.entity] = 1;
+            ++visibleCount;
+        });
+    }
+
+    bool isVisible(Entity entity) const { return entity < visible.size() && visible[entity] != 0; }
+    std::size_t getVisibleCount() const { return visibleCount; }
+
+private:
+    std::vector<std::uint8_t> visible; // индекс — Entity
+    bool allVisible = true;            // visible сейчас заполнен единицами
+    std::size_t visibleCount = 0;
+};
+
+// Двигает только бодрствующих (см. ActivitySet). Кто стоит с нулевой
+// скоростью, копит тики покоя и засыпает.
 class MovementSystem : public System {
 public:
-    void update(ComponentManager& cm) {
-        for (Entity e : entities) {
+    // Затухающее движение медленнее этого останавливается, чтобы объект мог уснуть
+    static constexpr float REST_SPEED = 0.01f;
+
+    void update(ComponentManager& cm, ActivitySet& activity) {
+        for (Entity e : activity.getAwake()) {
+            // без скорости сама не сдвинется (форт, стена)
+            if (!entities.count(e)) {
+                activity.markStill(e);
+                continue;
+            }
             auto& transform = cm.getComponent<TransformComponent>(e);
             auto& velocity = cm.getComponent<VelocityComponent>(e);
+            if (velocity.velocity.x == 0.0f && velocity.velocity.y == 0.0f) {
+                activity.markStill(e);
+                continue;
+            }
+            activity.markMoving(e);
 
             // Просто добавляем скорость к позиции (фиксированный шаг)
             transform.position.x += velocity.velocity.x * 0.016f;
@@ -104,85 +166,614 @@ public:
             if (!cm.hasComponent<AIComponent>(e)) {
                 velocity.velocity.x *= 0.95f;
                 velocity.velocity.y *= 0.95f;
+                if (velocity.velocity.length() < REST_SPEED) velocity.velocity = {0, 0};
             }
         }
     }
 };
 
+// Атакующий (или перезаряжающийся) стоит у цели: его обходят, а не сдвигают
+inline bool isAnchored(ComponentManager& cm, Entity e) {
+    return cm.hasComponent<AIComponent>(e) &&
+           cm.getComponent<AIComponent>(e).state != AIComponent::MOVING;
+}
+
+// AABB сущности в мире по границам меша; без меша — точка в её положении
+inline WorldRect worldBounds(ComponentManager& cm, const AssetRegistry& assets, Entity e) {
+    const Point& position = cm.getComponent<TransformComponent>(e).position;
+    if (!cm.hasComponent<MeshComponent>(e)) return {position.x, position.y, position.x, position.y};
+    const auto& bounds = assets.meshBounds(cm.getComponent<MeshComponent>(e).mesh);
+    return {position.x + bounds.minX, position.y + bounds.minY,
+            position.x + bounds.maxX, position.y + bounds.maxY};
+}
+
+// Расстояние между краями двух AABB; 0 — касаются или перекрываются
+inline float boundsGap(const WorldRect& a, const WorldRect& b) {
+    float dx = std::max({0.0f, b.minX - a.maxX, a.minX - b.maxX});
+    float dy = std::max({0.0f, b.minY - a.maxY, a.minY - b.maxY});
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+// Расталкивание толпы (separation из boids). Юнит отходит от ближайших
+// соседей тем быстрее, чем ближе они, — поверх движения, заданного AI, так
+// что толпа обтекает друг друга, а не отскакивает при столкновении. Сдвиги
+// считаются по положениям на начало тика и применяются разом, скорость не
+// трогают (у стоящего без цели юнита она бы копилась). Соседи берутся из
+// сетки сцены, учитываются не больше MAX_NEIGHBOURS ближайших — на тик O(N)
+// при любой плотности кучи. Расходятся только свои: противники сходятся
+// сами до дальности атаки. Атакующие стоят на месте — их обходят
+// остальные, а не сталкивают с цели. Перекрытие, которое мягкое
+// расталкивание не успело развести, исправляет CollisionSystem.
+class SeparationSystem : public System {
+public:
+    static constexpr int MAX_NEIGHBOURS = 6;
+    static constexpr float SEPARATION_RADIUS = 1.2f;   // ~ размер юнита
+    static constexpr float SEPARATION_STRENGTH = 2.0f; // скорость отталкивания вплотную
+    static constexpr float MAX_SEPARATION_SPEED = 1.5f;
+
+    SeparationSystem() : positions(MAX_ENTITIES), teams(MAX_ENTITIES, NO_TEAM) {}
+
+    // grid — положения на начало тика (до MovementSystem)
+    void update(ComponentManager& cm, const SpatialGrid& grid, ActivitySet& activity) {
+        // положения и команды — в массивы по id, чтобы не искать компоненты на каждого соседа
+        for (Entity e : entities) {
+            positions[e] = cm.getComponent<TransformComponent>(e).position;
+            teams[e] = cm.hasComponent<TeamComponent>(e) ? std::uint8_t(cm.getComponent<TeamComponent>(e).team)
+                                                         : NO_TEAM;
+        }
+        pushes.resize(entities.size());
+        std::size_t index = 0;
+        for (Entity e : entities) {
+            if (isAnchored(cm, e)) {
+                pushes[index++] = Point(0, 0);
+                continue;
+            }
+            const Point& position = positions[e];
+            Neighbour nearest[MAX_NEIGHBOURS];
+            int found = 0;
+            WorldRect area{position.x - SEPARATION_RADIUS, position.y - SEPARATION_RADIUS,
+                           position.x + SEPARATION_RADIUS, position.y + SEPARATION_RADIUS};
+            grid.query(area, [&](const SpatialGrid::Item& item) {
+                if (item.entity == e || !entities.count(item.entity) ||
+                    teams[item.entity] != teams[e]) return;
+                const Point& other = positions[item.entity];
+                float dx = position.x - other.x;
+                float dy = position.y - other.y;
+                float d2 = dx * dx + dy * dy;
+                if (!(d2 < SEPARATION_RADIUS * SEPARATION_RADIUS)) return;
+                insertNearest(nearest, found, Neighbour{item.entity, dx, dy, d2});
+            });
+
+            Point push(0, 0);
+            for (int i = 0; i < found; ++i) {
+                const Neighbour& n = nearest[i];
+                float distance = std::sqrt(n.d2);
+                float weight = SEPARATION_STRENGTH * (1.0f - distance / SEPARATION_RADIUS);
+                if (distance > 1e-4f) {
+                    push.x += n.dx / distance * weight;
+                    push.y += n.dy / distance * weight;
+                } else {
+                    // в одной точке — расходятся по y, направление по порядку id
+                    push.y += e < n.entity ? weight : -weight;
+                }
+            }
+            float length = push.length();
+            if (length > MAX_SEPARATION_SPEED) {
+                push.x *= MAX_SEPARATION_SPEED / length;
+                push.y *= MAX_SEPARATION_SPEED / length;
+            }
+            pushes[index++] = push;
+        }
+
+        index = 0;
+        for (Entity e : entities) {
+            const Point& push = pushes[index++];
+            if (push.x == 0.0f && push.y == 0.0f) continue;
+            auto& position = cm.getComponent<TransformComponent>(e).position;
+            position.x += push.x * 0.016f;
+            position.y += push.y * 0.016f;
+            activity.wake(e);
+        }
+    }
+
+private:
+    struct Neighbour {
+        Entity entity;
+        float dx, dy; // от соседа к юниту
+        float d2;
+    };
+
+    // Вставка в отсортированный по расстоянию массив из не больше MAX_NEIGHBOURS
+    // (при равенстве — по id, чтобы итог не зависел от порядка в сетке)
+    static void insertNearest(Neighbour* nearest, int& found, const Neighbour& candidate) {
+        auto closer = [](const Neighbour& a, const Neighbour& b) {
+            return a.d2 < b.d2 || (a.d2 == b.d2 && a.entity < b.entity);
+        };
+        if (found == MAX_NEIGHBOURS && !closer(candidate, nearest[found - 1])) return;
+        int i = found < MAX_NEIGHBOURS ? found++ : found - 1;
+        while (i > 0 && closer(candidate, nearest[i - 1])) {
+            nearest[i] = nearest[i - 1];
+            --i;
+        }
+        nearest[i] = candidate;
+    }
+
+    static constexpr std::uint8_t NO_TEAM = 0xFF;
+
+    std::vector<Point> positions;      // индекс — Entity
+    std::vector<std::uint8_t> teams;   // индекс — Entity
+    std::vector<Point> pushes;         // по порядку entities
+};
+
 
+// Столкновения подвижных юнитов со статичными препятствиями (Collidable без
+// Velocity: стены, форты) и друг с другом. Цель атакующего сталкивается
+// с ним, как любая другая: дальность атаки меряется от края до края AABB
+// (boundsGap), так что бойцу ближнего боя не нужно заходить внутрь цели.
+//
+// Препятствия и юниты раскладываются в свои сетки, юнит проверяет только
+// соседей. Пересечение AABB даёт контакт: нормаль по оси наименьшего
+// перекрытия и глубину. Перекрытие исправляется сдвигом (с допуском
+// PENETRATION_SLOP). Из препятствия выталкивается юнит, составляющая его
+// скорости внутрь гасится. Пару юнитов расталкивает поровну, но стоящий у цели
+// (isAnchored) не сдвигается, пока второй может уступить, — так стоящие
+// атакующие не наползают друг на друга, а подошедший не сталкивает их.
+// Контакты хранятся между тиками по паре сущностей: если с прошлого решения
+// никто из пары не сдвинулся (атакующие стоят у форта и плечом к плечу),
+// контакт "спит" и заново не решается. Спящие юниты (ActivitySet) сами
+// не проверяются, но их может задеть бодрствующий.
+// Кэш контактов — вектор, отсортированный по паре, и пересобирается
+// в конце тика во втором векторе: новый контакт не заводит узел в куче.
 class CollisionSystem : public System {
+public:
+    // Вне кадра столкновения проверяются раз в столько тиков (вразнобой по id)
+    static constexpr std::uint32_t OFFSCREEN_COLLISION_TICKS = 4;
+    // Остаточное перекрытие, которое не исправляется: контакт у стены
+    // сохраняется и может уснуть, а не рвётся и возникает заново
+    static constexpr float PENETRATION_SLOP = 0.01f;
+    // Контакт, не подтверждённый столько тиков, выбрасывается из кэша
+    static constexpr std::uint32_t CONTACT_TTL_TICKS = 8;
+
+    // Для пары юнитов body — меньший id, obstacle — больший
+    struct Contact {
+        Point normal;            // от препятствия к юниту
+        float depth = 0.0f;      // перекрытие до исправления
+        Point bodyPosition;      // положение юнита после исправления
+        Point obstaclePosition;
+        std::uint32_t lastTick = 0;
+        std::uint32_t restingTicks = 0; // тиков подряд без пересчёта
+    };
+
+    CollisionSystem() : positions(MAX_ENTITIES), boxes(MAX_ENTITIES), anchored(MAX_ENTITIES, 0),
+                        checked(MAX_ENTITIES, 0) {}
+
+    void update(ComponentManager& components, const AssetRegistry& assets,
+                const VisibilitySystem& visibility, ActivitySet& activity, std::uint32_t tick) {
+        // положения, AABB и признаки — в массивы по id, чтобы не искать компоненты на каждую пару
+        obstacles.clear();
+        bodies.clear();
+        for (Entity e : entities) {
+            positions[e] = components.getComponent<TransformComponent>(e).position;
+            boxes[e] = worldBounds(components, assets, e);
+            bool body = components.hasComponent<VelocityComponent>(e);
+            anchored[e] = body && isAnchored(components, e);
+            checked[e] = body && activity.isAwake(e) &&
+                         (visibility.isVisible(e) || (tick + e) % OFFSCREEN_COLLISION_TICKS == 0);
+            if (body) bodies.insert(e, boxes[e]);
+            else obstacles.insert(e, boxes[e]);
+        }
+        obstacles.build();
+        bodies.build();
+        lastSolvedCount = 0;
+        lastRestingCount = 0;
+
+        for (Entity a : activity.getAwake()) {
+            if (!entities.count(a) || !checked[a]) continue;
+            // сначала соседи, потом стены: последним юнита ставит препятствие
+            collideWithBodies(components, activity, a, tick);
+            if (collideWithObstacles(components, a, tick)) activity.markMoving(a);
+        }
+        // будить во время обхода getAwake() нельзя
+        for (Entity e : pushedAsleep) {
+            activity.wake(e);
+        }
+        pushedAsleep.clear();
+
+        // Не тронутые на этом тике контакты доживают до CONTACT_TTL_TICKS
+        for (const KeyedContact& old : contacts) {
+            if (!old.seen && tick - old.contact.lastTick <= CONTACT_TTL_TICKS) fresh.push_back(old);
+        }
+        std::sort(fresh.begin(), fresh.end(),
+                  [](const KeyedContact& a, const KeyedContact& b) { return a.key < b.key; });
+        contacts.swap(fresh);
+        fresh.clear();
+    }
+
+    // Для пары юнитов порядок аргументов не важен
+    const Contact* findContact(Entity body, Entity obstacle) const {
+        if (const Contact* contact = findStored(pairKey(body, obstacle))) return contact;
+        return findStored(pairKey(obstacle, body));
+    }
+    std::size_t getContactCount() const { return contacts.size(); }
+    // Сколько контактов на последнем тике решено заново и сколько пропущено как спящие
+    std::size_t getLastSolvedCount() const { return lastSolvedCount; }
+    std::size_t getLastRestingCount() const { return lastRestingCount; }
+
 private:
-    struct AABB {
-        float minX, maxX, minY, maxY;
+    struct KeyedContact {
+        std::uint64_t key;
+        Contact contact;
+        bool seen; // на этом тике уже обновлён или снят
     };
 
-    AABB getAABB(const TransformComponent& transform, const MeshComponent& mesh) {
-        float minX = std::numeric_limits<float>::max();
-        float maxX = std::numeric_limits<float>::lowest();
-        float minY = std::numeric_limits<float>::max();
-        float maxY = std::numeric_limits<float>::lowest();
+    static std::uint64_t pairKey(Entity body, Entity obstacle) {
+        return std::uint64_t(body) << 32 | obstacle;
+    }
+    static bool keyLess(const KeyedContact& contact, std::uint64_t key) { return contact.key < key; }
+
+    const Contact* findStored(std::uint64_t key) const {
+        auto it = std::lower_bound(contacts.begin(), contacts.end(), key, keyLess);
+        return it != contacts.end() && it->key == key ? &it->contact : nullptr;
+    }
+
+    // Контакт прошлого тика или nullptr
+    KeyedContact* findCached(std::uint64_t key) {
+        auto it = std::lower_bound(contacts.begin(), contacts.end(), key, keyLess);
+        return it != contacts.end() && it->key == key ? &*it : nullptr;
+    }
+
+    // Контакт с прошлого решения не сдвинулся — продлевается без пересчёта
+    bool stillResting(std::uint64_t key, Entity body, Entity obstacle, std::uint32_t tick) {
+        KeyedContact* cached = findCached(key);
+        if (!cached) return false;
+        cached->seen = true;
+        if (!samePosition(cached->contact.bodyPosition, positions[body]) ||
+            !samePosition(cached->contact.obstaclePosition, positions[obstacle])) {
+            return false;
+        }
+        Contact resting = cached->contact;
+        resting.lastTick = tick;
+        ++resting.restingTicks;
+        fresh.push_back({key, resting, false});
+        ++lastRestingCount;
+        return true;
+    }
+
+    // Перекрытие по осям; контакт — по оси, где оно меньше. false — не пересекаются
+    static bool findPenetration(const WorldRect& box, const WorldRect& obstacle, Contact& contact) {
+        float overlapX = std::min(box.maxX, obstacle.maxX) - std::max(box.minX, obstacle.minX);
+        float overlapY = std::min(box.maxY, obstacle.maxY) - std::max(box.minY, obstacle.minY);
+        if (!(overlapX > 0.0f && overlapY > 0.0f)) return false;
+        float bodyCenterX = (box.minX + box.maxX) / 2;
+        float bodyCenterY = (box.minY + box.maxY) / 2;
+        float obstacleCenterX = (obstacle.minX + obstacle.maxX) / 2;
+        float obstacleCenterY = (obstacle.minY + obstacle.maxY) / 2;
+        if (overlapX < overlapY) {
+            contact.normal = Point(bodyCenterX < obstacleCenterX ? -1.0f : 1.0f, 0.0f);
+            contact.depth = overlapX;
+        } else {
+            contact.normal = Point(0.0f, bodyCenterY < obstacleCenterY ? -1.0f : 1.0f);
+            contact.depth = overlapY;
+        }
+        return true;
+    }
+
+    // Сдвиг юнита вдоль normal
+    void shift(ComponentManager& components, Entity e, const Point& normal, float distance) {
+        float dx = normal.x * distance;
+        float dy = normal.y * distance;
+        positions[e].x += dx;
+        positions[e].y += dy;
+        boxes[e] = {boxes[e].minX + dx, boxes[e].minY + dy, boxes[e].maxX + dx, boxes[e].maxY + dy};
+        components.getComponent<TransformComponent>(e).position = positions[e];
+    }
+
+    // Юнит сдвинут соседом: бодрствующий не засыпает, спящий будится после обхода
+    void markPushed(ActivitySet& activity, Entity e) {
+        if (activity.isAwake(e)) activity.markMoving(e);
+        else pushedAsleep.push_back(e);
+    }
+
+    void collideWithBodies(ComponentManager& components, ActivitySet& activity, Entity a, std::uint32_t tick) {
+        touching.clear();
+        bodies.query(boxes[a], [&](const SpatialGrid::Item& item) {
+            if (item.entity != a) touching.push_back(item);
+        });
+
+        for (const SpatialGrid::Item& neighbour : touching) {
+            // Пару решает меньший id из проверяемых на этом тике — ровно один раз
+            if (neighbour.entity < a && checked[neighbour.entity]) continue;
+            Entity body = std::min(a, neighbour.entity);
+            Entity other = std::max(a, neighbour.entity);
+            std::uint64_t key = pairKey(body, other);
+            if (stillResting(key, body, other, tick)) continue;
+
+            Contact contact;
+            if (!findPenetration(boxes[body], boxes[other], contact)) continue;
+            ++lastSolvedCount;
+
+            // Только сдвиг: скорость идущего AI задаёт заново каждый тик, у стоящего она нулевая.
+            // Уступает тот, кто не стоит у цели; оба стоят или оба идут — поровну.
+            float correction = contact.depth - PENETRATION_SLOP;
+            if (correction > 0.0f) {
+                float bodyShare = anchored[body] == anchored[other] ? 0.5f : (anchored[body] ? 0.0f : 1.0f);
+                if (bodyShare > 0.0f) {
+                    shift(components, body, contact.normal, correction * bodyShare);
+                    markPushed(activity, body);
+                }
+                if (bodyShare < 1.0f) {
+                    shift(components, other, Point(-contact.normal.x, -contact.normal.y),
+                          correction * (1.0f - bodyShare));
+                    markPushed(activity, other);
+                }
+            }
+
+            contact.bodyPosition = positions[body];
+            contact.obstaclePosition = positions[other];
+            contact.lastTick = tick;
+            fresh.push_back({key, contact, false});
+        }
+    }
+
+    // true — юнит вытолкнут (сдвинулся)
+    bool collideWithObstacles(ComponentManager& components, Entity a, std::uint32_t tick) {
+        touching.clear();
+        obstacles.query(boxes[a], [&](const SpatialGrid::Item& item) {
+            touching.push_back(item);
+        });
+        bool moved = false;
+
+        for (const SpatialGrid::Item& obstacle : touching) {
+            std::uint64_t key = pairKey(a, obstacle.entity);
+            if (stillResting(key, a, obstacle.entity, tick)) continue;
 
-        for (const auto& v : mesh.vertices) {
-            Point world { transform.position.x + v.x, transform.position.y + v.y };
-            minX = std::min(minX, world.x);
-            maxX = std::max(maxX, world.x);
-            minY = std::min(minY, world.y);
-            maxY = std::max(maxY, world.y);
+            Contact contact;
+            if (!findPenetration(boxes[a], obstacle.bounds, contact)) continue;
+            ++lastSolvedCount;
+
+            // Выталкивание и гашение скорости внутрь препятствия
+            float correction = contact.depth - PENETRATION_SLOP;
+            if (correction > 0.0f) {
+                moved = true;
+                shift(components, a, contact.normal, correction);
+            }
+            auto& velocity = components.getComponent<VelocityComponent>(a).velocity;
+            float into = velocity.x * contact.normal.x + velocity.y * contact.normal.y;
+            if (into < 0.0f) {
+                velocity.x -= contact.normal.x * into;
+                velocity.y -= contact.normal.y * into;
+            }
+
+            contact.bodyPosition = positions[a];
+            contact.obstaclePosition = positions[obstacle.entity];
+            contact.lastTick = tick;
+            fresh.push_back({key, contact, false});
         }
+        return moved;
+    }
 
-        return { minX, maxX, minY, maxY };
+    static bool samePosition(const Point& a, const Point& b) {
+        return a.x == b.x && a.y == b.y;
     }
 
-    bool checkCollision(const AABB& box1, const AABB& box2) {
-        bool noCollision = (box1.maxX < box2.minX) ||
-                           (box1.minX > box2.maxX) ||
-                           (box1.maxY < box2.minY) ||
-                           (box1.minY > box2.maxY);
-        return !noCollision;
+    SpatialGrid obstacles;
+    SpatialGrid bodies;                 // подвижные юниты на начало проверки
+    std::vector<Point> positions;       // индекс — Entity
+    std::vector<WorldRect> boxes;       // индекс — Entity
+    std::vector<std::uint8_t> anchored; // индекс — Entity; isAnchored на начало тика
+    std::vector<std::uint8_t> checked;  // индекс — Entity; проверяется на этом тике
+    std::vector<SpatialGrid::Item> touching;
+    std::vector<Entity> pushedAsleep;   // спящие, сдвинутые соседом на этом тике
+    std::vector<KeyedContact> contacts; // с прошлого тика, по возрастанию key
+    std::vector<KeyedContact> fresh;    // этого тика, в порядке обхода
+    std::size_t lastSolvedCount = 0;
+    std::size_t lastRestingCount = 0;
+};
+
+// Отмечает на карте статичные препятствия — Collidable без Velocity (стены,
+// форты) из collidables. false — таких нет.
+inline bool blockStaticObstacles(ComponentManager& cm, const AssetRegistry& assets,
+                                 const EntitySet& collidables, NavGrid& grid) {
+    bool hasObstacles = false;
+    for (Entity e : collidables) {
+        if (cm.hasComponent<VelocityComponent>(e)) continue;
+        const Point& position = cm.getComponent<TransformComponent>(e).position;
+        const auto& bounds = assets.meshBounds(cm.getComponent<MeshComponent>(e).mesh);
+        grid.blockRect({position.x + bounds.minX, position.y + bounds.minY,
+                        position.x + bounds.maxX, position.y + bounds.maxY});
+        hasObstacles = true;
     }
+    return hasObstacles;
+}
 
+// Обход стен для массы юнитов. На каждую команду — одно поле направлений
+// к ближайшему противнику поверх карты статичных препятствий (Collidable
+// без Velocity: стены, форты); юнит берёт направление из своей клетки за O(1).
+// Поле считает фоновый поток: раз в REBUILD_TICKS тиков забирается поле,
+// заказанное на прошлом шаге, и заказывается новое по текущим положениям.
+class FlowFieldSystem : public System {
 public:
-    void update(ComponentManager& components) {
-        for (Entity a : entities) {
-            if (!components.hasComponent<TransformComponent>(a) ||
-                !components.hasComponent<MeshComponent>(a) ||
-                !components.hasComponent<CollidableComponent>(a)) {
-                continue;
+    static constexpr std::uint32_t REBUILD_TICKS = 15; // ~4 раза в секунду
+
+    void update(ComponentManager& cm, const AssetRegistry& assets, std::uint32_t tick) {
+        if (tick % REBUILD_TICKS != 0) return;
+        if (worker.hasJob()) {
+            current = worker.takeResult();
+        }
+
+        FlowFieldWorker::Job& job = worker.prepareJob(config);
+        // Без препятствий прямая и есть кратчайший путь
+        if (!blockStaticObstacles(cm, assets, entities, job.grid)) {
+            current = nullptr;
+            return;
+        }
+
+        cm.forEachEntityWith<TeamComponent>([&](Entity other, const TeamComponent& team) {
+            if (!cm.hasComponent<TransformComponent>(other)) return;
+            if (cm.hasComponent<HealthComponent>(other) &&
+                cm.getComponent<HealthComponent>(other).health <= 0) return;
+            int cell = job.grid.cellAt(cm.getComponent<TransformComponent>(other).position);
+            if (cell < 0) return;
+            for (int t = 0; t < FlowFieldWorker::TEAM_COUNT; ++t) {
+                if (t != team.team) job.goals[t].push_back(cell);
             }
+        });
+        worker.submit();
+    }
 
-            const auto& ta = components.getComponent<TransformComponent>(a);
-            const auto& ma = components.getComponent<MeshComponent>(a);
-            auto boxA = getAABB(ta, ma);
+    // Направление для юнита команды team; false — поля нет или из этой
+    // клетки противника не достичь
+    bool sample(TeamComponent::Team team, const Point& position, Point& direction) const {
+        return current && current->fields[team].sample(current->grid, position, direction);
+    }
 
-            for (Entity b : entities) {
-                if (a == b) continue;
+    // Без готового поля считается, что стен нет
+    bool isPathClear(const Point& from, const Point& to, float stopShort) const {
+        return !current || current->grid.isPathClear(from, to, stopShort);
+    }
 
-                if (!components.hasComponent<TransformComponent>(b) ||
-                    !components.hasComponent<MeshComponent>(b) ||
-                    !components.hasComponent<CollidableComponent>(b)) {
-                    continue;
-                }
+    void setConfig(const NavGridConfig& newConfig) { config = newConfig; }
 
-                const auto& tb = components.getComponent<TransformComponent>(b);
-                const auto& mb = components.getComponent<MeshComponent>(b);
-                auto boxB = getAABB(tb, mb);
+private:
+    NavGridConfig config;
+    FlowFieldWorker worker;
+    const FlowFieldWorker::Result* current = nullptr; // буфер воркера
+};
 
-                if (checkCollision(boxA, boxB)) {
-                    // Реакция на столкновение (например, откат позиции или смена направления)
-                    if (components.hasComponent<VelocityComponent>(a)) {
-                        auto& va = components.getComponent<VelocityComponent>(a);
-                        va.velocity.x = -va.velocity.x;
-                        va.velocity.y = -va.velocity.y;
-                    }
-                }
+// Собственные пути для юнитов с PathComponent. Карта препятствий та же,
+// что у FlowFieldSystem; граф HPA* перестраивается, только когда на ней
+// что-то изменилось. Поиски идут в PathWorkers; ответ выдаётся ровно
+// через PATH_LATENCY_TICKS тиков после запроса, в порядке запросов (тик
+// ждёт, только если потоки отстали больше), так что симуляция от скорости
+// потоков не зависит.
+class PathfindingSystem : public System {
+public:
+    static constexpr std::uint32_t REBUILD_TICKS = 15;
+    static constexpr std::uint32_t PATH_LATENCY_TICKS = 2;
+
+    // collidables — сущности с Transform + Mesh + Collidable
+    void update(ComponentManager& cm, const AssetRegistry& assets,
+                const EntitySet& collidables, std::uint32_t tick) {
+        if (tick % REBUILD_TICKS == 0) {
+            rebuild(cm, assets, collidables);
+        }
+        if (tick >= PATH_LATENCY_TICKS) {
+            deliver(cm, tick - PATH_LATENCY_TICKS);
+        }
+
+        // Все запросы тика видят один и тот же кэш маршрутов
+        const std::uint32_t cacheVersion = pathfinder ? pathfinder->routeCount() : 0;
+        for (Entity e : entities) {
+            auto& path = cm.getComponent<PathComponent>(e);
+            if (!path.replan) continue;
+            path.replan = false;
+            if (!pathfinder) {
+                path.waypoints.clear();
+                path.requestId = 0;
+                continue;
             }
+            if (++lastRequestId == 0) ++lastRequestId;
+            path.requestId = lastRequestId;
+            workers.submit({e, path.requestId, tick,
+                            cm.getComponent<TransformComponent>(e).position, path.goal,
+                            pathfinder, cacheVersion});
         }
     }
+
+    // Текущий граф; nullptr — препятствий нет
+    const HierarchicalPathfinder* getPathfinder() const { return pathfinder.get(); }
+
+    void setConfig(const NavGridConfig& newConfig) { config = newConfig; }
+
+private:
+    void rebuild(ComponentManager& cm, const AssetRegistry& assets, const EntitySet& collidables) {
+        grid.reset(config);
+        if (!blockStaticObstacles(cm, assets, collidables, grid)) {
+            pathfinder.reset();
+            return;
+        }
+        if (pathfinder && pathfinder->getGrid().sameCells(grid)) return;
+        pathfinder = std::make_shared<const HierarchicalPathfinder>(grid);
+
+        // Старые маршруты могут идти сквозь новые стены
+        for (Entity e : entities) {
+            auto& path = cm.getComponent<PathComponent>(e);
+            if (!path.waypoints.empty() || path.requestId != 0) path.replan = true;
+        }
+    }
+
+    void deliver(ComponentManager& cm, std::uint32_t lastTick) {
+        delivered.clear();
+        workers.collect(lastTick, delivered);
+        for (auto& result : delivered) {
+            // Кэш маршрутов пополняется только здесь, по порядку запросов:
+            // какие записи увидит следующий запрос, от потоков не зависит
+            result.pathfinder->storeRoute(std::move(result.route));
+            // сущность удалена, или её id уже у другой, или цель с тех пор сменилась
+            if (!entities.count(result.entity)) continue;
+            auto& path = cm.getComponent<PathComponent>(result.entity);
+            if (path.requestId != result.id) continue;
+            path.waypoints = std::move(result.waypoints);
+            path.next = 0;
+            path.requestId = 0;
+        }
+    }
+
+    NavGridConfig config;
+    NavGrid grid; // карта для сравнения с графом, память между перестройками одна
+    std::shared_ptr<const HierarchicalPathfinder> pathfinder;
+    std::uint32_t lastRequestId = 0;
+    std::vector<PathWorkers::Result> delivered;
+    PathWorkers workers;
+};
+
+// Расписание поиска целей. Юнит пересматривает цель раз в retargetTicks
+// тиков, в свой тик (сдвиг по id), так что за тик цель ищут примерно
+// N / retargetTicks юнитов; между поисками он идёт к прежней цели.
+// Вне очереди ищут новые юниты и те, чья цель погибла или пропала.
+// 1 / 1 — поиск каждый тик, как раньше.
+struct AISchedule {
+    std::uint32_t retargetTicks = 4;
+    std::uint32_t offscreenRetargetTicks = 16; // для юнитов вне кадра камеры
+    // Потолок поисков за тик (0 — без потолка): не уложившиеся ждут
+    // следующего тика. Срезает всплески, когда цель теряют многие сразу.
+    std::uint32_t maxRetargetsPerTick = 0;
 };
 
 class AISystem : public System {
 public:
-    void update(ComponentManager& cm, SystemManager& sm, EntityManager& em, EventBus& eventBus) {
+    AISystem() : diedMarks(MAX_ENTITIES, 0) { diedTargets.reserve(MAX_ENTITIES); }
+
+    // Гибель цели сбрасывает её у всех, кто на неё шёл
+    void connect(EventBus& bus) {
+        bus.channel<EntityDiedEvent>().connect<&AISystem::onEntitiesDied>(this);
+    }
+
+    void setSchedule(const AISchedule& newSchedule) {
+        schedule = newSchedule;
+        schedule.retargetTicks = std::max<std::uint32_t>(schedule.retargetTicks, 1);
+        schedule.offscreenRetargetTicks = std::max<std::uint32_t>(schedule.offscreenRetargetTicks, 1);
+    }
+    const AISchedule& getSchedule() const { return schedule; }
+
+    // Сколько раз на последнем тике вызывался findTarget
+    std::uint32_t getLastRetargetCount() const { return lastRetargetCount; }
+
+    // Ближе этого к цели юнит идёт к ней напрямую, даже за стеной
+    static constexpr float FLOW_FIELD_NEAR_DISTANCE = 2.0f;
+    // Цель ушла от конца маршрута дальше этого — маршрут ищется заново
+    static constexpr float PATH_REPLAN_DISTANCE = 2.0f;
+    // Точка поворота считается пройденной ближе этого
+    static constexpr float WAYPOINT_RADIUS = 0.3f;
+
+    // Дальность атаки меряется от края до края AABB (boundsGap): цель —
+    // препятствие для CollisionSystem, к её центру не подойти
+    void update(ComponentManager& cm, const AssetRegistry& assets, SystemManager& sm, EntityManager& em,
+                EventBus& eventBus, const VisibilitySystem& visibility, const FlowFieldSystem& flowFields,
+                ActivitySet& activity, std::uint32_t tick) {
+        invalidateDiedTargets(cm);
+        lastRetargetCount = 0;
+
         for (Entity e : entities) {
             auto& ai = cm.getComponent<AIComponent>(e);
             auto& combat = cm.getComponent<CombatComponent>(e);
@@ -190,47 +781,75 @@ public:
             auto& team = cm.getComponent<TeamComponent>(e);
 
             if (ai.state == AIComponent::MOVING) {
-                combat.target = findTarget(cm, e, team.team);
+                // id цели мог достаться новой сущности — такую цель не ждём
+                if (combat.target != MAX_ENTITIES && !isValidTarget(cm, combat.target, team.team)) {
+                    combat.target = MAX_ENTITIES;
+                    ai.needsRetarget = true;
+                }
+                std::uint32_t interval = visibility.isVisible(e) ? schedule.retargetTicks
+                                                                 : schedule.offscreenRetargetTicks;
+                bool due = ai.needsRetarget || (tick + e) % interval == 0;
+                bool withinBudget = schedule.maxRetargetsPerTick == 0 ||
+                                    lastRetargetCount < schedule.maxRetargetsPerTick;
+                if (due && withinBudget) {
+                    combat.target = findTarget(cm, e, team.team);
+                    ai.needsRetarget = false;
+                    ai.followFlowField = combat.target != MAX_ENTITIES &&
+                        !flowFields.isPathClear(transform.position,
+                                                cm.getComponent<TransformComponent>(combat.target).position,
+                                                FLOW_FIELD_NEAR_DISTANCE);
+                    if (ai.followFlowField && cm.hasComponent<PathComponent>(e)) {
+                        requestPath(cm.getComponent<PathComponent>(e),
+                                    cm.getComponent<TransformComponent>(combat.target).position);
+                    }
+                    ++lastRetargetCount;
+                }
                 if (combat.target != MAX_ENTITIES) {
                     auto& targetTransform = cm.getComponent<TransformComponent>(combat.target);
                     float dx = targetTransform.position.x - transform.position.x;
                     float dy = targetTransform.position.y - transform.position.y;
                     float distance = std::sqrt(dx * dx + dy * dy);
 
-                    if (distance <= combat.attackRange) {
+                    if (inRange(cm, assets, e, combat)) {
                         ai.state = AIComponent::ATTACKING;
                         auto& velocity = cm.getComponent<VelocityComponent>(e);
                         velocity.velocity = {0, 0}; // стопаем движение
                     } else {
-                        // Двигаться к цели
+                        // Двигаться к цели; если путь перекрыт — в обход по полю
                         auto& velocity = cm.getComponent<VelocityComponent>(e);
                         float speed = 1.5f;
-                        velocity.velocity.x = (dx / distance) * speed;
-                        velocity.velocity.y = (dy / distance) * speed;
+                        Point direction(dx / distance, dy / distance);
+                        if (ai.followFlowField && distance > FLOW_FIELD_NEAR_DISTANCE) {
+                            // свой маршрут, пока он есть; до его прихода — общее поле
+                            bool onPath = cm.hasComponent<PathComponent>(e) &&
+                                followPath(cm.getComponent<PathComponent>(e), transform.position, direction);
+                            if (!onPath) {
+                                flowFields.sample(team.team, transform.position, direction);
+                            }
+                        }
+                        velocity.velocity.x = direction.x * speed;
+                        velocity.velocity.y = direction.y * speed;
+                        activity.wake(e);
                     }
                 }
             }
 
             if (ai.state == AIComponent::ATTACKING || ai.state == AIComponent::RELOADING) {
-                // Стоим на месте
+                // Стоим на месте (уже стоящего — спящего — не трогаем)
                 if (cm.hasComponent<VelocityComponent>(e)) {
                     auto& velocity = cm.getComponent<VelocityComponent>(e);
-                    velocity.velocity = {0, 0};
+                    if (velocity.velocity.x != 0.0f || velocity.velocity.y != 0.0f) velocity.velocity = {0, 0};
                 }
 
                 if (combat.target == MAX_ENTITIES ||
                     !cm.hasComponent<HealthComponent>(combat.target)) {
                     ai.state = AIComponent::MOVING;
                     combat.target = MAX_ENTITIES;
+                    ai.needsRetarget = true;
                     continue;
                 }
 
-                auto& targetTransform = cm.getComponent<TransformComponent>(combat.target);
-                float dx = targetTransform.position.x - transform.position.x;
-                float dy = targetTransform.position.y - transform.position.y;
-                float distance = std::sqrt(dx * dx + dy * dy);
-
-                if (distance > combat.attackRange) {
+                if (!inRange(cm, assets, e, combat)) {
                     ai.state = AIComponent::MOVING;
                     continue;
                 }
@@ -250,6 +869,10 @@ public:
     }
 
 private:
+    static bool inRange(ComponentManager& cm, const AssetRegistry& assets, Entity e, const CombatComponent& combat) {
+        return boundsGap(worldBounds(cm, assets, e), worldBounds(cm, assets, combat.target)) <= combat.attackRange;
+    }
+
     bool isInFront(const TransformComponent& seeker, const TransformComponent& target, TeamComponent::Team seekerTeam) {
         if (seekerTeam == TeamComponent::ALLY) {
             return target.position.x > seeker.position.x;
@@ -258,15 +881,78 @@ private:
         }
     }
 
+    // Новый маршрут нужен, если его нет и не ищется или цель от него ушла
+    static void requestPath(PathComponent& path, const Point& goal) {
+        bool idle = path.waypoints.empty() && path.requestId == 0;
+        if (idle || (goal - path.goal).length() > PATH_REPLAN_DISTANCE) {
+            path.goal = goal;
+            path.replan = true;
+        }
+    }
+
+    // Направление на текущую точку маршрута; false — маршрута нет или он пройден
+    static bool followPath(PathComponent& path, const Point& position, Point& direction) {
+        while (path.next < path.waypoints.size() &&
+               (path.waypoints[path.next] - position).length() < WAYPOINT_RADIUS) {
+            ++path.next;
+        }
+        if (path.next >= path.waypoints.size()) return false;
+        Point delta = path.waypoints[path.next] - position;
+        float length = delta.length();
+        direction = Point(delta.x / length, delta.y / length);
+        return true;
+    }
+
+    // Погибшие за тик приходят пачкой из EventBus, а цели сбрасываются
+    // в начале следующего update() — до того, как их id переиспользуют
+    void onEntitiesDied(EventSpan<EntityDiedEvent> events) {
+        for (const auto& event : events) {
+            diedTargets.push_back(event.entity);
+        }
+    }
+
+    void invalidateDiedTargets(ComponentManager& cm) {
+        if (diedTargets.empty()) return;
+        for (Entity died : diedTargets) {
+            if (died < MAX_ENTITIES) diedMarks[died] = 1;
+        }
+        for (Entity e : entities) {
+            auto& combat = cm.getComponent<CombatComponent>(e);
+            if (combat.target < MAX_ENTITIES && diedMarks[combat.target]) {
+                combat.target = MAX_ENTITIES;
+                cm.getComponent<AIComponent>(e).needsRetarget = true;
+            }
+        }
+        for (Entity died : diedTargets) {
+            if (died < MAX_ENTITIES) diedMarks[died] = 0;
+        }
+        diedTargets.clear();
+    }
+
+    // Цель жива и всё ещё враг (id мог достаться новой сущности)
+    bool isValidTarget(ComponentManager& cm, Entity target, TeamComponent::Team seekerTeam) {
+        if (target == MAX_ENTITIES ||
+            !cm.hasComponent<HealthComponent>(target) ||
+            !cm.hasComponent<TransformComponent>(target) ||
+            !cm.hasComponent<TeamComponent>(target)) {
+            return false;
+        }
+        return cm.getComponent<HealthComponent>(target).health > 0 &&
+               cm.getComponent<TeamComponent>(target).team != seekerTeam;
+    }
+
     Entity findTarget(ComponentManager& cm, Entity seeker, TeamComponent::Team seekerTeam) {
         const auto& seekerTransform = cm.getComponent<TransformComponent>(seeker);
         Entity closestTarget = MAX_ENTITIES;
         float minDistance = std::numeric_limits<float>::max();
 
-        for (Entity other : cm.getAllEntitiesWith<TeamComponent>()) {
-            if (other == seeker) continue;
+        cm.forEachEntityWith<TeamComponent>([&](Entity other, const TeamComponent& otherTeam) {
+            if (other == seeker) return;
+
+            // уже убитые в этом тике ждут удаления до точки синхронизации
+            if (cm.hasComponent<HealthComponent>(other) &&
+                cm.getComponent<HealthComponent>(other).health <= 0) return;
 
-            auto& otherTeam = cm.getComponent<TeamComponent>(other);
             if (otherTeam.team != seekerTeam && cm.hasComponent<TransformComponent>(other)) {
                 const auto& otherTransform = cm.getComponent<TransformComponent>(other);
 
@@ -281,7 +967,7 @@ private:
                     }
                 }
             }
-        }
+        });
 
         return closestTarget;
     }
@@ -297,19 +983,29 @@ private:
 
         // Просто уменьшаем здоровье каждый раз при атаке
         auto& targetHealth = cm.getComponent<HealthComponent>(combat.target);
+        if (targetHealth.health <= 0) {
+            // цель уже убита кем-то другим в этом тике, удаление отложено
+            combat.target = MAX_ENTITIES;
+            return;
+        }
         float oldHp = targetHealth.health;
         targetHealth.health  -= combat.damage;
 
-        eventBus.publish(HealthChangedEvent(combat.target, oldHp, targetHealth.health));
+        eventBus.enqueue(HealthChangedEvent(combat.target, oldHp, targetHealth.health));
 
         qDebug() << "Entity" << attacker << "attacks! Target health:" << targetHealth.health;
         if (targetHealth.health <= 0) {
             qDebug() << "Entity" << combat.target << "died!";
-            eventBus.publish(EntityDiedEvent(combat.target, attacker));
+            eventBus.enqueue(EntityDiedEvent(combat.target, attacker));
             combat.target = MAX_ENTITIES;
         }
     }
 
+    AISchedule schedule;
+    std::uint32_t lastRetargetCount = 0;
+    std::vector<Entity> diedTargets;
+    std::vector<std::uint8_t> diedMarks; // индекс — Entity, на время invalidateDiedTargets
+
 };
 
 struct WinConditionSystem : System {
@@ -325,47 +1021,47 @@ struct WinConditionSystem : System {
 
 class DeathSystem {
 public:
-    DeathSystem(EventBus& bus, ComponentManager& cm, SystemManager& sm, EntityManager& em)
-        : componentManager(cm), systemManager(sm), entityManager(em)
+    DeathSystem(EventBus& bus, CommandBuffer& commands)
+        : commandBuffer(commands)
     {
-        bus.subscribe<EntityDiedEvent>(
-            [this](const EntityDiedEvent& event) {
-                this->onEntityDied(event);
-            }
-            );
+        bus.channel<EntityDiedEvent>().connect<&DeathSystem::onEntitiesDied>(this);
     }
 private:
-    ComponentManager& componentManager;
-    SystemManager& systemManager;
-    EntityManager& entityManager;
+    CommandBuffer& commandBuffer;
 
-    void onEntityDied(const EntityDiedEvent& event) {
-        systemManager.removeEntityFromAllSystems(event.entity);
-        componentManager.removeEntity(event.entity);
-        entityManager.destroyEntity(event.entity);
+    // Сущность не удаляется сразу, а ставится в очередь до конца тика:
+    // событие может прийти и синхронно через publish
+    void onEntitiesDied(EventSpan<EntityDiedEvent> events) {
+        for (const auto& event : events) {
+            commandBuffer.destroyEntity(event.entity);
+        }
     }
 };
 
 class HealthChangeSystem {
 public:
     HealthChangeSystem(EventBus& bus) {
-        bus.subscribe<HealthChangedEvent>(
-            [](const HealthChangedEvent& event) {
-                qDebug() << "[HealthChangeSystem] Entity" << event.entity
-                         << "HP changed from" << event.oldHealth
-                         << "to" << event.newHealth;
-                // Здесь можно вызывать анимации, обновлять GUI и т.д.
-            }
-            );
+        bus.channel<HealthChangedEvent>().connect<&HealthChangeSystem::onHealthChanged>(this);
+    }
+private:
+    void onHealthChanged(EventSpan<HealthChangedEvent> events) {
+        for (const auto& event : events) {
+            qDebug() << "[HealthChangeSystem] Entity" << event.entity
+                     << "HP changed from" << event.oldHealth
+                     << "to" << event.newHealth;
+        }
+        // Здесь можно вызывать анимации, обновлять GUI и т.д.
     }
 };
 
 struct ResourceSystem : System {
     void update(ComponentManager& cm) {
+        static const ResourceId elixirId = resourceId("elixir");
         for (Entity e : cm.getAllEntitiesWith<ResourceComponent>()) {
             auto& res = cm.getComponent<ResourceComponent>(e);
-            res.resources["elixir"] += 0.03f; // ~+1 за 30 апдейтов (0.5 сек при 60 FPS)
-            if (res.resources["elixir"] > 10.0f) res.resources["elixir"] = 10.0f; // max cap
+            float& elixir = res.resources[elixirId];
+            elixir += 0.03f; // ~+1 за 30 апдейтов (0.5 сек при 60 FPS)
+            if (elixir > 10.0f) elixir = 10.0f; // max cap
         }
     }
 };
@@ -0,0 +1,9 @@
+include(../engine.pri)
+
+# Бенчмарк, не тест: в make check не входит
+CONFIG -= testcase
+
+TARGET = bench_aischedule
+
+SOURCES += \
+    main.cpp
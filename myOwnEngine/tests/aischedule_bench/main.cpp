@@ -0,0 +1,50 @@
+#include <chrono>
+#include <cstdio>
+#include "testscene.h"
+
+// Время тика при разных расписаниях поиска целей (AISchedule): одна и та же
+// сцена на TICKS тиков, среднее время тика. Собирать в release.
+
+namespace {
+
+const int UNITS_PER_SIDE = 200;
+const int TICKS = 1200;
+const std::uint32_t SEED = 1;
+
+double millisecondsPerTick(const AISchedule& schedule, std::size_t& alive)
+{
+    Scene scene;
+    loadTestPrefabs(scene);
+    scene.setAISchedule(schedule);
+    summonTestBattle(scene, UNITS_PER_SIDE, SEED);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < TICKS; ++tick) {
+        scene.update();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    alive = scene.getAllEntities().size();
+    return std::chrono::duration<double, std::milli>(elapsed).count() / TICKS;
+}
+
+} // namespace
+
+int main()
+{
+    const AISchedule schedules[] = {
+        {1, 1, 0},
+        {4, 16, 0},
+        {8, 32, 0},
+        {4, 16, 20},
+    };
+
+    std::printf("%d units per side, %d ticks\n", UNITS_PER_SIDE, TICKS);
+    for (const AISchedule& schedule : schedules) {
+        std::size_t alive = 0;
+        double ms = millisecondsPerTick(schedule, alive);
+        std::printf("K=%u offscreen=%u cap=%-3u %8.3f ms/tick  alive after: %zu\n",
+                    schedule.retargetTicks, schedule.offscreenRetargetTicks,
+                    schedule.maxRetargetsPerTick, ms, alive);
+    }
+    return 0;
+}
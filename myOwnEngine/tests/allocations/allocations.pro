@@ -0,0 +1,6 @@
+include(../engine.pri)
+
+TARGET = tst_allocations
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,76 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include "testscene.h"
+
+// Тик в установившемся режиме не обращается к глобальному аллокатору:
+// временное берётся из арены кадра, буферы систем переиспользуются.
+// Считаются выделения только из потока тика — поиски путей в PathWorkers
+// живут в своих потоках и к бюджету тика не относятся.
+//
+// Сцена сначала разгоняется WARMUP_TICKS тиков (армии сходятся, буферы
+// дорастают до рабочего размера), затем MEASURED_TICKS тиков считаются.
+// В измеряемом отрезке идёт бой: юниты гибнут, пути перезаказываются.
+
+namespace {
+
+const int UNITS_PER_SIDE = 100;
+const std::uint32_t SEED = 1;
+const int WARMUP_TICKS = 1200;
+const int MEASURED_TICKS = 600;
+
+std::atomic<bool> counting{false};
+std::thread::id tickThread;
+std::atomic<long> allocations{0};
+
+void* allocate(std::size_t size) {
+    if (counting.load(std::memory_order_relaxed) && std::this_thread::get_id() == tickThread) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+int main()
+{
+    Scene scene;
+    loadTestPrefabs(scene);
+    summonTestBattle(scene, UNITS_PER_SIDE, SEED);
+
+    for (int tick = 0; tick < WARMUP_TICKS; ++tick) {
+        scene.update();
+    }
+    std::size_t aliveBefore = scene.getAllEntities().size();
+
+    tickThread = std::this_thread::get_id();
+    counting = true;
+    for (int tick = 0; tick < MEASURED_TICKS; ++tick) {
+        scene.update();
+    }
+    counting = false;
+    std::size_t aliveAfter = scene.getAllEntities().size();
+
+    std::printf("%d ticks: %ld allocations, entities %zu -> %zu\n",
+                MEASURED_TICKS, allocations.load(), aliveBefore, aliveAfter);
+    if (aliveAfter == aliveBefore) {
+        std::printf("FAIL: nobody died, the measured ticks did not cover combat\n");
+        return 1;
+    }
+    if (allocations.load() != 0) {
+        std::printf("FAIL: steady-state ticks allocated from the heap\n");
+        return 1;
+    }
+    std::printf("PASS\n");
+    return 0;
+}
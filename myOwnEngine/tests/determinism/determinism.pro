@@ -0,0 +1,6 @@
+include(../engine.pri)
+
+TARGET = tst_determinism
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,28 @@
+# Движок без окна и сервера: сцена, системы, навигация, сериализация.
+# Подключается из .pro каждого теста.
+QT = core
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+ENGINE = $$PWD/..
+INCLUDEPATH += $$ENGINE $$PWD
+
+SOURCES += \
+    $$ENGINE/commanddecoder.cpp \
+    $$ENGINE/entitybuilder.cpp \
+    $$ENGINE/camera/camera2d.cpp \
+    $$ENGINE/navigation/FlowField.cpp \
+    $$ENGINE/navigation/HierarchicalPathfinder.cpp \
+    $$ENGINE/navigation/PathWorkers.cpp \
+    $$ENGINE/point/point.cpp \
+    $$ENGINE/prefabs/PrefabRegistry.cpp \
+    $$ENGINE/scene/scene.cpp \
+    $$ENGINE/stateserializer.cpp
+
+HEADERS += \
+    $$PWD/testscene.h
+
+# prefabs.json читается прямо из исходников, без ресурсов Qt
+DEFINES += PREFABS_PATH=\\\"$$ENGINE/prefabs.json\\\"
+# Лог боя (qDebug на каждый удар) тестам не нужен
+DEFINES += QT_NO_DEBUG_OUTPUT
@@ -0,0 +1,87 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include "systems/Systems.h"
+
+// Время SeparationSystem вплоть до MAX_ENTITIES юнитов одной команды.
+// Юниты стоят в квадрате со стороной sqrt(N / density): при density = 1 —
+// около юнита на единицу площади, при 4 — толпа, где у каждого соседей больше
+// MAX_NEIGHBOURS. Отдельно меряется перестройка сетки: сцена делает её
+// каждый тик, когда кто-то сдвинулся. Собирать в release.
+
+namespace {
+
+const int TICKS = 200;
+const std::uint32_t SEED = 3;
+const float HALF_SIZE = 0.5f;  // половина стороны юнита в сетке
+
+struct Timing {
+    double gridMs = 0;
+    double separationMs = 0;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double milliseconds(Clock::duration elapsed)
+{
+    return std::chrono::duration<double, std::milli>(elapsed).count();
+}
+
+Timing measure(int units, float density)
+{
+    ComponentManager cm;
+    ActivitySet activity;
+    SeparationSystem separation;
+    SpatialGrid grid;
+
+    std::mt19937 rng(SEED);
+    const float side = std::sqrt(units / density);
+    std::uniform_real_distribution<float> coordinate(-side / 2, side / 2);
+    for (Entity e = 0; e < Entity(units); ++e) {
+        TransformComponent transform;
+        transform.position = Point(coordinate(rng), coordinate(rng));
+        cm.addComponent(e, transform);
+        cm.addComponent(e, TeamComponent(TeamComponent::ALLY));
+        separation.entities.insert(e);
+    }
+
+    Timing timing;
+    for (int tick = 0; tick < TICKS; ++tick) {
+        auto start = Clock::now();
+        grid.clear();
+        for (Entity e : separation.entities) {
+            const Point& p = cm.getComponent<TransformComponent>(e).position;
+            grid.insert(e, {p.x - HALF_SIZE, p.y - HALF_SIZE, p.x + HALF_SIZE, p.y + HALF_SIZE});
+        }
+        grid.build();
+        auto built = Clock::now();
+        separation.update(cm, grid, activity);
+        auto done = Clock::now();
+
+        timing.gridMs += milliseconds(built - start);
+        timing.separationMs += milliseconds(done - built);
+        activity.flush();
+    }
+    timing.gridMs /= TICKS;
+    timing.separationMs /= TICKS;
+    return timing;
+}
+
+} // namespace
+
+int main()
+{
+    const int unitCounts[] = {1000, 2500, int(MAX_ENTITIES)};
+    const float densities[] = {1.0f, 4.0f};
+
+    std::printf("%d ticks, MAX_ENTITIES = %d\n", TICKS, int(MAX_ENTITIES));
+    for (float density : densities) {
+        for (int units : unitCounts) {
+            Timing timing = measure(units, density);
+            std::printf("%5d units, density %.0f: grid %7.3f ms  separation %7.3f ms/tick\n",
+                        units, density, timing.gridMs, timing.separationMs);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,10 @@
+# Тесты движка: консольные программы, код возврата 0 — тест прошёл.
+# Тесты запускаются через make check; *_bench — бенчмарки, их запускают
+# вручную из release-сборки.
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    allocations \
+    determinism \
+    aischedule_bench \
+    separation_bench
@@ -0,0 +1,41 @@
+#ifndef TESTSCENE_H
+#define TESTSCENE_H
+
+#include <cstdint>
+#include <random>
+#include "commandhandler.h"
+#include "json.hpp"
+
+// Общая для тестов сцена: две армии по разные стороны стены с проходом,
+// каждый десятый союзник — лучник со своим путём. Юниты ставятся теми же
+// командами summon, что шлют клиенты. Строй сдвигается случайно, от seed:
+// одинаковый seed — одинаковая сцена.
+inline void loadTestPrefabs(Scene& scene) {
+    scene.getPrefabs().loadFromFile(PREFABS_PATH, scene.getAssets());
+}
+
+inline void summonTestBattle(Scene& scene, int unitsPerSide, std::uint32_t seed) {
+    // mt19937 выдаёт одно и то же на любой платформе, а std::*_distribution —
+    // нет, поэтому сдвиг в [-0.25, 0.25) считается вручную
+    std::mt19937 random(seed);
+    auto jitter = [&random] { return float(random() % 1000) / 2000.0f - 0.25f; };
+
+    nlohmann::json packet;
+    auto& commands = packet["commands"] = nlohmann::json::array();
+    for (int i = 0; i < unitsPerSide; ++i) {
+        float y = float(i % 25) * 0.5f - 6.0f;
+        float depth = float(i / 25) * 0.8f;
+        commands.push_back({{"action", "summon"}, {"unit", i % 10 == 0 ? "archer" : "soldier"},
+                            {"x", -3.0f - depth + jitter()}, {"y", y + jitter()}});
+        commands.push_back({{"action", "summon"}, {"unit", "enemy"},
+                            {"x", 3.0f + depth + jitter()}, {"y", y + jitter()}});
+    }
+    // стена поперёк поля с проходом у верхнего края
+    for (int k = 0; k < 10; ++k) {
+        commands.push_back({{"action", "summon"}, {"unit", "wall"}, {"x", 0.0f}, {"y", -9.0f + k}});
+    }
+    CommandHandler handler;
+    handler.handle(packet, scene);
+}
+
+#endif // TESTSCENE_H